@@ -0,0 +1,46 @@
+#!/bin/sh
+# Objective value reached in a fixed time on the B instances with 1, 4
+# and 16 threads, when they search independently (-j 0), share a
+# single elite pool (-j 8) and form a ring of islands (-j 8 -l 10).
+# Each run lasts <seconds> - 5 seconds (60 by default).
+#
+#    islands.sh <roadef2012-j10> <solution_checker> <instances_directory>
+#               [seconds]
+
+solver=$1
+checker=$2
+directory=$3
+seconds=${4:-65}
+output=${TMPDIR:-/tmp}/islands-bench.$$
+
+if [ ! -x "$solver" ] || [ ! -x "$checker" ] || [ ! -d "$directory" ]; then
+   echo "usage: $0 <roadef2012-j10> <solution_checker>" \
+      "<instances_directory> [seconds]" >&2
+   exit 1
+fi
+
+objective() {
+   "$solver" -t "$seconds" -s 1 -p "$1" -i "$2" -o "$output" -d $3 $4 \
+      2> /dev/null
+   "$checker" "$1" "$2" "$output" 1 2>&1 | tail -n 1
+}
+
+printf "%-8s %8s %14s %14s %14s\n" instance threads independent shared \
+   islands
+
+for model in "$directory"/model_b_*.txt; do
+   [ -s "$model" ] || continue
+
+   name=${model##*/model_}
+   name=${name%.txt}
+   assignment=$directory/assignment_$name.txt
+
+   for threads in 1 4 16; do
+      printf "%-8s %8s %14s %14s %14s\n" "$name" "$threads" \
+         "$(objective "$model" "$assignment" $threads "-j 0")" \
+         "$(objective "$model" "$assignment" $threads "-j 8")" \
+         "$(objective "$model" "$assignment" $threads "-j 8 -l 10")"
+   done
+done
+
+rm -f "$output"
@@ -0,0 +1,337 @@
+// Nanoseconds per call of the load cost, capacity, fused capacity and
+// load cost, and balance kernels, for each kernel set the processor
+// supports, reading the stride at run time and specialized for it, on
+// the a2 and b instances. The kernels are called on random (process,
+// machine) pairs of a perturbed solution.
+//
+//    kernels-bench <instances_directory>
+
+#include "kernels.hpp"
+#include "parser.hpp"
+#include "random_moves.hpp"
+#include "solution.hpp"
+
+#include <algorithm>
+#include <boost/random/mersenne_twister.hpp>
+#include <cstdio>
+#include <ctime>
+#include <glob.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+   int const numRuns = 5;
+   int const numPairs = 1 << 16;
+
+   kernels::Kernels const * const kernelSets[] = {
+      &kernels::scalar, &kernels::sse, &kernels::avx2
+   };
+
+   int const numKernelSets = sizeof(kernelSets) / sizeof(kernelSets[0]);
+
+   double now()
+   {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+   }
+
+   struct Pair
+   {
+      int process;
+      int srcMachine;
+      int dstMachine;
+   };
+
+   // Best of numRuns, in nanoseconds per call.
+   double timeLoadCost(kernels::Kernels const & kernels,
+                       inst::Instance const & instance,
+                       sol::MachineUsage<sol::DynamicTraits> const & usage,
+                       std::vector<Pair> const & pairs,
+                       long long * checksum)
+   {
+      double best = 1e30;
+
+      for (int run = 0; run < numRuns; run++)
+      {
+         long long sum = 0;
+         double start = now();
+
+         for (int i = 0; i < pairs.size(); i++)
+         {
+            sum += kernels.loadCostDelta(
+               instance.resourceStride(),
+               instance.process(pairs[i].process).requirements(),
+               instance.resourcesLoadCostWeight(),
+               usage.overSafetyCapacity(pairs[i].srcMachine),
+               usage.underSafetyCapacity(pairs[i].dstMachine));
+         }
+
+         best = std::min(best, now() - start);
+         *checksum = sum;
+      }
+
+      return best * 1e9 / pairs.size();
+   }
+
+   double timeCapacity(kernels::Kernels const & kernels,
+                       inst::Instance const & instance,
+                       sol::MachineUsage<sol::DynamicTraits> const & usage,
+                       std::vector<Pair> const & pairs,
+                       long long * checksum)
+   {
+      double best = 1e30;
+
+      for (int run = 0; run < numRuns; run++)
+      {
+         long long sum = 0;
+         double start = now();
+
+         for (int i = 0; i < pairs.size(); i++)
+         {
+            int process = pairs[i].process;
+            int dstMachine = pairs[i].dstMachine;
+
+            sum += kernels.fitsCapacity(
+               instance.resourceStride(),
+               usage.usageWithTransient(dstMachine),
+               instance.process(process).requirements(),
+               instance.machine(dstMachine).capacities(),
+               instance.transientMask(),
+               dstMachine == instance.initAssignment()[process]);
+         }
+
+         best = std::min(best, now() - start);
+         *checksum = sum;
+      }
+
+      return best * 1e9 / pairs.size();
+   }
+
+   // The checksum counts the moves which don't fit as 1.
+   double timeFused(kernels::Kernels const & kernels,
+                    inst::Instance const & instance,
+                    sol::MachineUsage<sol::DynamicTraits> const & usage,
+                    std::vector<Pair> const & pairs,
+                    long long * checksum)
+   {
+      double best = 1e30;
+
+      for (int run = 0; run < numRuns; run++)
+      {
+         long long sum = 0;
+         double start = now();
+
+         for (int i = 0; i < pairs.size(); i++)
+         {
+            int process = pairs[i].process;
+            int dstMachine = pairs[i].dstMachine;
+            inst::integer delta;
+
+            if (kernels.fitsLoadCostDelta(
+                   instance.resourceStride(),
+                   instance.process(process).requirements(),
+                   instance.resourcesLoadCostWeight(),
+                   instance.transientMask(),
+                   dstMachine == instance.initAssignment()[process],
+                   usage.overSafetyCapacity(pairs[i].srcMachine),
+                   usage.usageWithTransient(dstMachine),
+                   instance.machine(dstMachine).capacities(),
+                   usage.underSafetyCapacity(dstMachine),
+                   &delta))
+               sum += delta;
+            else
+               sum += 1;
+         }
+
+         best = std::min(best, now() - start);
+         *checksum = sum;
+      }
+
+      return best * 1e9 / pairs.size();
+   }
+
+   double timeBalance(kernels::Kernels const & kernels,
+                      inst::Instance const & instance,
+                      kernels::BalanceCosts const & balanceCosts,
+                      sol::MachineUsage<sol::DynamicTraits> const & usage,
+                      std::vector<Pair> const & pairs,
+                      long long * checksum)
+   {
+      double best = 1e30;
+
+      for (int run = 0; run < numRuns; run++)
+      {
+         long long sum = 0;
+         double start = now();
+
+         for (int i = 0; i < pairs.size(); i++)
+         {
+            int srcMachine = pairs[i].srcMachine;
+            int dstMachine = pairs[i].dstMachine;
+
+            sum += kernels.balanceDelta(
+               balanceCosts,
+               instance.process(pairs[i].process).requirements(),
+               usage.usage(srcMachine),
+               instance.machine(srcMachine).capacities(),
+               usage.usage(dstMachine),
+               instance.machine(dstMachine).capacities());
+         }
+
+         best = std::min(best, now() - start);
+         *checksum = sum;
+      }
+
+      return best * 1e9 / pairs.size();
+   }
+
+   void bench(std::string const & name, inst::Instance const & instance)
+   {
+      sol::Solution solution(&instance);
+      solution.applyDelta(solution.computeObjValue());
+
+      RandomMoves randomMoves(1, instance, instance.numProcesses() / 10);
+      randomMoves.apply(solution);
+
+      sol::State state(&instance, solution.assignment());
+      sol::AssignmentCounts counts
+         = sol::AssignmentCounts::compute(&instance, state.assignment, 1);
+      sol::MachineUsage<sol::DynamicTraits> usage(state, counts);
+
+      boost::mt19937 gen(1);
+      std::vector<Pair> pairs(numPairs);
+
+      for (int i = 0; i < numPairs; i++)
+      {
+         pairs[i].process = gen() % instance.numProcesses();
+         pairs[i].srcMachine = state.assignment[pairs[i].process];
+         pairs[i].dstMachine = gen() % instance.numMachines();
+      }
+
+      std::vector<int> firstResources;
+      std::vector<int> secondResources;
+      std::vector<inst::integer> targets;
+      std::vector<inst::integer> weights;
+
+      for (int i = 0; i < instance.numBalanceCosts(); i++)
+      {
+         firstResources.push_back(instance.balanceCost(i).firstResource());
+         secondResources.push_back(instance.balanceCost(i).secondResource());
+         targets.push_back(instance.balanceCost(i).target());
+         weights.push_back(instance.balanceCost(i).weight());
+      }
+
+      kernels::BalanceCosts balanceCosts = {
+         instance.numBalanceCosts(),
+         firstResources.empty() ? 0 : &firstResources[0],
+         secondResources.empty() ? 0 : &secondResources[0],
+         targets.empty() ? 0 : &targets[0],
+         weights.empty() ? 0 : &weights[0]
+      };
+
+      long long loadCostReference = 0;
+      long long capacityReference = 0;
+      long long fusedReference = 0;
+      long long balanceReference = 0;
+
+      for (int i = 0; i < 2 * numKernelSets; i++)
+      {
+         bool specialized = (i % 2 == 1);
+         kernels::Kernels const & kernels = specialized
+            ? kernels::specialize(*kernelSets[i / 2],
+                                  instance.resourceStride())
+            : *kernelSets[i / 2];
+
+         if (!kernels::isSupported(kernels))
+            continue;
+
+         long long loadCostChecksum;
+         long long capacityChecksum;
+         long long fusedChecksum;
+         long long balanceChecksum;
+
+         double loadCostTime = timeLoadCost(kernels, instance, usage, pairs,
+                                            &loadCostChecksum);
+         double capacityTime = timeCapacity(kernels, instance, usage, pairs,
+                                            &capacityChecksum);
+         double fusedTime = timeFused(kernels, instance, usage, pairs,
+                                      &fusedChecksum);
+         double balanceTime = timeBalance(kernels, instance, balanceCosts,
+                                          usage, pairs, &balanceChecksum);
+
+         if (i == 0)
+         {
+            loadCostReference = loadCostChecksum;
+            capacityReference = capacityChecksum;
+            fusedReference = fusedChecksum;
+            balanceReference = balanceChecksum;
+         }
+
+         bool mismatch = loadCostChecksum != loadCostReference
+            || capacityChecksum != capacityReference
+            || fusedChecksum != fusedReference
+            || balanceChecksum != balanceReference;
+
+         std::printf("%-8s %3d %2d %-8s %-5s %14.2f %14.2f %14.2f %14.2f%s\n",
+                     name.c_str(), instance.numResources(),
+                     instance.numBalanceCosts(), kernels.name,
+                     specialized ? "yes" : "no", loadCostTime,
+                     capacityTime, fusedTime, balanceTime,
+                     mismatch ? "  MISMATCH" : "");
+      }
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc != 2)
+   {
+      std::fprintf(stderr, "usage: %s <instances_directory>\n", argv[0]);
+      return 1;
+   }
+
+   std::string directory(argv[1]);
+   glob_t models;
+
+   if (glob((directory + "/model_a2_*.txt").c_str(), 0, 0, &models) != 0
+       || glob((directory + "/model_b_*.txt").c_str(), GLOB_APPEND, 0,
+               &models) != 0)
+   {
+      std::fprintf(stderr, "No a2 or b instance found in %s\n", argv[1]);
+      return 1;
+   }
+
+   std::printf("%-8s %3s %2s %-8s %-5s %14s %14s %14s %14s\n", "instance",
+               "R", "B", "kernels", "fixed", "loadCost(ns)", "capacity(ns)",
+               "fused(ns)", "balance(ns)");
+
+   for (size_t i = 0; i < models.gl_pathc; i++)
+   {
+      std::string model(models.gl_pathv[i]);
+      std::string name(model.substr(model.rfind("model_") + 6));
+      std::string assignment(directory + "/assignment_" + name);
+      name = name.substr(0, name.size() - 4);
+
+      inst::Instance * instance;
+
+      try
+      {
+         instance = Parser::parse(model, assignment);
+      }
+      catch (std::exception const &)
+      {
+         continue;
+      }
+
+      if (instance->numProcesses() > 0)
+         bench(name, *instance);
+
+      delete instance;
+   }
+
+   globfree(&models);
+
+   return 0;
+}
@@ -0,0 +1,151 @@
+// Parse time per instance: the former stream extraction (ifstream >>)
+// against the memory mapped tokenizer, and the complete Parser::parse.
+//
+//    parse-bench <instances_directory>
+
+#include "parser.hpp"
+#include "tokenizer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <glob.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+   int const numRuns = 5;
+
+   double now()
+   {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+   }
+
+   long long streamScan(std::string const & filename)
+   {
+      std::ifstream file(filename.c_str());
+      long long sum = 0;
+      int value;
+
+      while (file >> value)
+         sum += value;
+
+      return sum;
+   }
+
+   long long tokenizerScan(std::string const & filename)
+   {
+      Tokenizer file(filename);
+      long long sum = 0;
+      inst::integer value;
+
+      while (file.next(value))
+         sum += value;
+
+      return sum;
+   }
+
+   long long fullParse(std::string const & model,
+                       std::string const & assignment)
+   {
+      inst::Instance * instance = Parser::parse(model, assignment);
+      long long size = instance->numProcesses();
+      delete instance;
+      return size;
+   }
+
+   // Best of numRuns, in milliseconds.
+   template <typename Function>
+   double time(Function function, long long * checksum)
+   {
+      double best = 1e30;
+
+      for (int i = 0; i < numRuns; i++)
+      {
+         double start = now();
+         *checksum = function();
+         best = std::min(best, now() - start);
+      }
+
+      return best * 1000;
+   }
+
+   struct StreamScan
+   {
+      std::string filename;
+      long long operator()() const { return streamScan(filename); }
+   };
+
+   struct TokenizerScan
+   {
+      std::string filename;
+      long long operator()() const { return tokenizerScan(filename); }
+   };
+
+   struct FullParse
+   {
+      std::string model;
+      std::string assignment;
+      long long operator()() const { return fullParse(model, assignment); }
+   };
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc != 2)
+   {
+      std::fprintf(stderr, "usage: %s <instances_directory>\n", argv[0]);
+      return 1;
+   }
+
+   std::string directory(argv[1]);
+   glob_t models;
+
+   if (glob((directory + "/model_*.txt").c_str(), 0, 0, &models) != 0)
+   {
+      std::fprintf(stderr, "No instance found in %s\n", argv[1]);
+      return 1;
+   }
+
+   std::printf("%-14s %9s %11s %11s %8s %10s %11s\n", "instance", "size(MB)",
+               "stream(ms)", "mapped(ms)", "speedup", "MB/s", "parse(ms)");
+
+   for (size_t i = 0; i < models.gl_pathc; i++)
+   {
+      std::string model(models.gl_pathv[i]);
+      std::string name(model.substr(model.rfind("model_") + 6));
+      std::string assignment(directory + "/assignment_" + name);
+      name = name.substr(0, name.size() - 4);
+
+      std::ifstream file(model.c_str(), std::ios::binary | std::ios::ate);
+      double size = file.tellg() / (1024.0 * 1024.0);
+
+      if (size <= 0)
+         continue;
+
+      long long streamSum;
+      long long tokenizerSum;
+      long long numProcesses;
+
+      StreamScan streamScan = { model };
+      TokenizerScan tokenizerScan = { model };
+      FullParse fullParse = { model, assignment };
+
+      double streamTime = time(streamScan, &streamSum);
+      double tokenizerTime = time(tokenizerScan, &tokenizerSum);
+      double parseTime = time(fullParse, &numProcesses);
+
+      std::printf("%-14s %9.2f %11.2f %11.2f %7.1fx %10.0f %11.2f%s\n",
+                  name.c_str(), size, streamTime, tokenizerTime,
+                  streamTime / tokenizerTime, size / tokenizerTime * 1000,
+                  parseTime, streamSum == tokenizerSum ? "" : "  MISMATCH");
+   }
+
+   globfree(&models);
+
+   return 0;
+}
@@ -0,0 +1,129 @@
+// Time to rebuild a Solution from an assignment, per instance and
+// number of threads. The assignment is the initial one perturbed by
+// random moves, so that some processes are away from their initial
+// machine.
+//
+//    rebuild-bench <instances_directory>
+
+#include "parser.hpp"
+#include "random_moves.hpp"
+#include "solution.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <glob.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+   int const numRuns = 5;
+   int const numThreads[] = { 1, 2, 4, 8 };
+   int const numConfigs = sizeof(numThreads) / sizeof(numThreads[0]);
+
+   double now()
+   {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+   }
+
+   // Best of numRuns, in milliseconds. The objective value of the
+   // rebuilt solution is computed from scratch in *check.
+   double time(inst::Instance const * instance,
+               sol::Solution const & solution,
+               int numThreads,
+               inst::integer * check)
+   {
+      double best = 1e30;
+
+      for (int i = 0; i < numRuns; i++)
+      {
+         double start = now();
+         sol::Solution rebuilt(instance, solution.assignment(),
+                               solution.objValue(), numThreads);
+         best = std::min(best, now() - start);
+
+         *check = rebuilt.computeObjValue().objValue();
+      }
+
+      return best * 1000;
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc != 2)
+   {
+      std::fprintf(stderr, "usage: %s <instances_directory>\n", argv[0]);
+      return 1;
+   }
+
+   std::string directory(argv[1]);
+   glob_t models;
+
+   if (glob((directory + "/model_*.txt").c_str(), 0, 0, &models) != 0)
+   {
+      std::fprintf(stderr, "No instance found in %s\n", argv[1]);
+      return 1;
+   }
+
+   std::printf("%-14s %9s", "instance", "processes");
+
+   for (int i = 0; i < numConfigs; i++)
+      std::printf(" %7dt(ms)", numThreads[i]);
+
+   std::printf("\n");
+
+   for (size_t i = 0; i < models.gl_pathc; i++)
+   {
+      std::string model(models.gl_pathv[i]);
+      std::string name(model.substr(model.rfind("model_") + 6));
+      std::string assignment(directory + "/assignment_" + name);
+      name = name.substr(0, name.size() - 4);
+
+      inst::Instance * instance;
+
+      try
+      {
+         instance = Parser::parse(model, assignment);
+      }
+      catch (std::exception const &)
+      {
+         continue;
+      }
+
+      if (instance->numProcesses() == 0)
+      {
+         delete instance;
+         continue;
+      }
+
+      sol::Solution solution(instance);
+      solution.applyDelta(solution.computeObjValue());
+
+      RandomMoves randomMoves(1, *instance, instance->numProcesses() / 10);
+      randomMoves.apply(solution);
+
+      std::printf("%-14s %9d", name.c_str(), instance->numProcesses());
+
+      bool mismatch = false;
+
+      for (int j = 0; j < numConfigs; j++)
+      {
+         inst::integer check;
+         std::printf(" %12.2f", time(instance, solution, numThreads[j],
+                                     &check));
+         mismatch |= (check != solution.objValue().objValue());
+      }
+
+      std::printf("%s\n", mismatch ? "  MISMATCH" : "");
+
+      delete instance;
+   }
+
+   globfree(&models);
+
+   return 0;
+}
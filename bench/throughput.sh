@@ -0,0 +1,39 @@
+#!/bin/sh
+# Moves evaluated per second by the local search on every instance,
+# with the solver specialized for the instance and with the generic
+# one (--generic). Each run lasts about one second.
+#
+#    throughput.sh <roadef2012-j10> <instances_directory>
+
+solver=$1
+directory=$2
+output=${TMPDIR:-/tmp}/throughput-bench.$$
+
+if [ ! -x "$solver" ] || [ ! -d "$directory" ]; then
+   echo "usage: $0 <roadef2012-j10> <instances_directory>" >&2
+   exit 1
+fi
+
+rate() {
+   "$solver" -t 6 -s 1 -p "$1" -i "$2" -o "$output" --stats $3 2>&1 \
+      | sed -n 's/.*, \([0-9]*\) moves\/s.*/\1/p'
+}
+
+printf "%-8s %14s %14s %8s\n" instance generic specialized speedup
+
+for model in "$directory"/model_*.txt; do
+   [ -s "$model" ] || continue
+
+   name=${model##*/model_}
+   name=${name%.txt}
+   assignment=$directory/assignment_$name.txt
+
+   generic=$(rate "$model" "$assignment" --generic)
+   specialized=$(rate "$model" "$assignment")
+
+   printf "%-8s %14s %14s %8s\n" "$name" "$generic" "$specialized" \
+      "$(echo "$generic $specialized" \
+         | awk '{ if ($1 > 0) printf "%.2fx", $2 / $1 }')"
+done
+
+rm -f "$output"
@@ -0,0 +1,134 @@
+#ifndef ALIGNED_ARRAY_HPP
+#define ALIGNED_ARRAY_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+// Fixed-size, zero-initialized (by default) array of trivially
+// copyable values whose storage is aligned on a cache line. Copies are
+// a single memcpy and reuse the destination storage when the sizes
+// match; moves only transfer the storage. The storage comes from the
+// global operator new, so that the allocation counter
+// (J10_COUNT_ALLOCATIONS) sees it.
+template <typename T>
+class AlignedArray
+{
+public:
+   static const std::size_t alignment = 64;
+
+   AlignedArray()
+      : _data(0),
+        _size(0)
+   {
+   }
+
+   explicit AlignedArray(std::size_t size)
+      : _data(allocate(size)),
+        _size(size)
+   {
+      std::memset(_data, 0, size * sizeof(T));
+   }
+
+   // Leaves the values uninitialized: the pages of a large array are
+   // then only backed by memory once written.
+   struct Uninitialized {};
+
+   AlignedArray(std::size_t size, Uninitialized)
+      : _data(allocate(size)),
+        _size(size)
+   {
+   }
+
+   AlignedArray(AlignedArray const & other)
+      : _data(allocate(other._size)),
+        _size(other._size)
+   {
+      copy(other);
+   }
+
+   AlignedArray(AlignedArray && other)
+      : _data(other._data),
+        _size(other._size)
+   {
+      other._data = 0;
+      other._size = 0;
+   }
+
+   ~AlignedArray()
+   {
+      deallocate(_data);
+   }
+
+   AlignedArray & operator=(AlignedArray const & other)
+   {
+      if (this != &other)
+      {
+         if (_size != other._size)
+         {
+            AlignedArray(other._size).swap(*this);
+         }
+
+         copy(other);
+      }
+
+      return *this;
+   }
+
+   AlignedArray & operator=(AlignedArray && other)
+   {
+      swap(other);
+      return *this;
+   }
+
+   void swap(AlignedArray & other)
+   {
+      std::swap(_data, other._data);
+      std::swap(_size, other._size);
+   }
+
+   T & operator[](std::size_t index) { return _data[index]; }
+   T const & operator[](std::size_t index) const { return _data[index]; }
+
+   T * data() { return _data; }
+   T const * data() const { return _data; }
+
+   std::size_t size() const { return _size; }
+
+private:
+   // The block from operator new is over-allocated by an alignment
+   // and a pointer, which holds the start of the block and is stored
+   // just before the aligned storage.
+   static T * allocate(std::size_t size)
+   {
+      if (size == 0)
+         return 0;
+
+      char * block = static_cast<char *>(
+         ::operator new(size * sizeof(T) + alignment + sizeof(void *)));
+      std::size_t start = reinterpret_cast<std::size_t>(
+         block + sizeof(void *));
+      char * data = block + sizeof(void *)
+         + (alignment - start % alignment) % alignment;
+
+      reinterpret_cast<void **>(data)[-1] = block;
+      return reinterpret_cast<T *>(data);
+   }
+
+   static void deallocate(T * data)
+   {
+      if (data != 0)
+         ::operator delete(reinterpret_cast<void **>(data)[-1]);
+   }
+
+   void copy(AlignedArray const & other)
+   {
+      if (_size != 0)
+         std::memcpy(_data, other._data, _size * sizeof(T));
+   }
+
+   T * _data;
+   std::size_t _size;
+};
+
+#endif
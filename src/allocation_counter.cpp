@@ -0,0 +1,84 @@
+#include "allocation_counter.hpp"
+
+#ifdef J10_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+   thread_local unsigned long long numAllocations = 0;
+
+   void * allocate(std::size_t size)
+   {
+      numAllocations++;
+
+      void * data = std::malloc(size == 0 ? 1 : size);
+
+      if (data == 0)
+         throw std::bad_alloc();
+
+      return data;
+   }
+}
+
+void * operator new(std::size_t size)
+{
+   return allocate(size);
+}
+
+void * operator new[](std::size_t size)
+{
+   return allocate(size);
+}
+
+void * operator new(std::size_t size, std::nothrow_t const &) noexcept
+{
+   try
+   {
+      return allocate(size);
+   }
+   catch (std::bad_alloc const &)
+   {
+      return 0;
+   }
+}
+
+void * operator new[](std::size_t size, std::nothrow_t const &) noexcept
+{
+   return operator new(size, std::nothrow);
+}
+
+void operator delete(void * data) noexcept
+{
+   std::free(data);
+}
+
+void operator delete[](void * data) noexcept
+{
+   std::free(data);
+}
+
+void operator delete(void * data, std::nothrow_t const &) noexcept
+{
+   std::free(data);
+}
+
+void operator delete[](void * data, std::nothrow_t const &) noexcept
+{
+   std::free(data);
+}
+
+unsigned long long alloc::count()
+{
+   return numAllocations;
+}
+
+#else
+
+unsigned long long alloc::count()
+{
+   return 0;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+// Test hook: when the program is built with J10_COUNT_ALLOCATIONS
+// defined, the global operator new is replaced by one which counts the
+// heap allocations of each thread. Otherwise the count is always 0.
+namespace alloc
+{
+   // Number of heap allocations made so far by the calling thread.
+   unsigned long long count();
+}
+
+#endif
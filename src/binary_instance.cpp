@@ -0,0 +1,465 @@
+#include "binary_instance.hpp"
+#include "mapped_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+   char const magic[4] = { 'J', '1', '0', 'I' };
+
+   // Written in the native byte order: read back swapped, it tells
+   // that the file comes from a host with another byte order.
+   uint32_t const byteOrderMark = 0x01020304;
+
+   struct Header
+   {
+      char magic[4];
+      uint32_t byteOrderMark;
+      uint32_t version;
+      uint32_t reserved;
+      uint64_t payloadSize;
+      uint64_t checksum;
+   };
+
+   class Writer
+   {
+   public:
+      void int32(int value) { append(static_cast<int32_t>(value)); }
+      void int64(inst::integer value) { append(static_cast<int64_t>(value)); }
+
+      void bytes(unsigned char const * data, size_t size)
+      {
+         _payload.insert(_payload.end(), data, data + size);
+      }
+
+      // The payload is padded to a multiple of 8 bytes so that the
+      // checksum can be computed one word at a time.
+      std::vector<char> const & payload()
+      {
+         while (_payload.size() % 8 != 0)
+            _payload.push_back(0);
+
+         return _payload;
+      }
+
+   private:
+      template <typename T>
+      void append(T value)
+      {
+         char const * bytes = reinterpret_cast<char const *>(&value);
+         _payload.insert(_payload.end(), bytes, bytes + sizeof(T));
+      }
+
+      std::vector<char> _payload;
+   };
+
+   class Reader
+   {
+   public:
+      Reader(char const * data, uint64_t size)
+         : _data(data),
+           _size(size),
+           _pos(0)
+      {
+      }
+
+      int int32() { return read<int32_t>(); }
+      inst::integer int64() { return read<int64_t>(); }
+
+      // Reads the number of items which follow, each taking at least
+      // itemSize bytes of the payload.
+      int count(uint64_t itemSize)
+      {
+         int count = int32();
+
+         if (count < 0
+             || (itemSize > 0 && count > (_size - _pos) / itemSize))
+            throw BinaryInstance::BadFormat("invalid count");
+
+         return count;
+      }
+
+      // Reads an index in [0, size).
+      int index(int size, char const * what)
+      {
+         int index = int32();
+
+         if (index < 0 || index >= size)
+            throw BinaryInstance::BadFormat(std::string("invalid ") + what);
+
+         return index;
+      }
+
+      uint64_t remaining() const { return _size - _pos; }
+
+      template <typename T, typename OutputIterator>
+      void fillArray(int size, OutputIterator result)
+      {
+         if (size < 0)
+            throw BinaryInstance::BadFormat("negative array size");
+
+         check(static_cast<uint64_t>(size) * sizeof(T));
+
+         for (int i = 0; i < size; i++)
+         {
+            T value;
+            std::memcpy(&value, _data + _pos, sizeof(T));
+            _pos += sizeof(T);
+            *result = value;
+         }
+      }
+
+      // Returns a pointer to the next "size" bytes of the payload.
+      unsigned char const * bytes(uint64_t size)
+      {
+         check(size);
+
+         unsigned char const * data
+            = reinterpret_cast<unsigned char const *>(_data + _pos);
+         _pos += size;
+         return data;
+      }
+
+   private:
+      template <typename T>
+      T read()
+      {
+         check(sizeof(T));
+
+         T value;
+         std::memcpy(&value, _data + _pos, sizeof(T));
+         _pos += sizeof(T);
+         return value;
+      }
+
+      void check(uint64_t numBytes) const
+      {
+         if (numBytes > _size - _pos)
+            throw BinaryInstance::BadFormat("truncated payload");
+      }
+
+      char const * _data;
+      uint64_t _size;
+      uint64_t _pos;
+   };
+}
+
+bool BinaryInstance::isBinary(std::string const & filename)
+{
+   std::ifstream file(filename.c_str(), std::ios::binary);
+
+   char buffer[sizeof(magic)];
+
+   if (!file.read(buffer, sizeof(buffer)))
+      return false;
+
+   return std::memcmp(buffer, magic, sizeof(magic)) == 0;
+}
+
+void BinaryInstance::write(inst::Instance const & instance,
+                           std::string const & filename)
+{
+   Writer writer;
+
+   int numResources = instance.numResources();
+   int numMachines = instance.numMachines();
+
+   writer.int32(numResources);
+   writer.int32(numMachines);
+   writer.int32(instance.numServices());
+   writer.int32(instance.numProcesses());
+   writer.int32(instance.numBalanceCosts());
+   writer.int32(instance.numNeighborhoods());
+   writer.int32(instance.numLocations());
+   writer.int32(instance.processMoveCostWeight());
+   writer.int32(instance.serviceMoveCostWeight());
+   writer.int32(instance.machineMoveCostWeight());
+
+   for (int i = 0; i < numResources; i++)
+   {
+      writer.int32(instance.resource(i).transient());
+      writer.int32(instance.resource(i).loadCostWeight());
+   }
+
+   for (int i = 0; i < numMachines; i++)
+   {
+      inst::Machine const & machine = instance.machine(i);
+
+      writer.int32(machine.neighborhood());
+      writer.int32(machine.location());
+
+      for (int j = 0; j < numResources; j++)
+         writer.int64(machine.capacity(j));
+
+      for (int j = 0; j < numResources; j++)
+         writer.int64(machine.safetyCapacity(j));
+   }
+
+   // The move cost matrix is written as is, with its own width.
+   std::vector<unsigned char> const & moveCosts = instance.moveCosts().data();
+
+   writer.int32(instance.moveCosts().width());
+   writer.bytes(&moveCosts[0], moveCosts.size());
+
+   for (int i = 0; i < instance.numServices(); i++)
+   {
+      std::vector<int> const & dependencies
+         = instance.service(i).dependencies();
+
+      writer.int32(instance.service(i).spreadMin());
+      writer.int32(dependencies.size());
+
+      for (int j = 0; j < dependencies.size(); j++)
+         writer.int32(dependencies[j]);
+   }
+
+   for (int i = 0; i < instance.numProcesses(); i++)
+   {
+      inst::Process const & process = instance.process(i);
+
+      writer.int32(process.service());
+      writer.int32(process.moveCost());
+
+      for (int j = 0; j < numResources; j++)
+         writer.int64(process.requirement(j));
+   }
+
+   for (int i = 0; i < instance.numBalanceCosts(); i++)
+   {
+      inst::BalanceCost const & balanceCost = instance.balanceCost(i);
+
+      writer.int32(balanceCost.firstResource());
+      writer.int32(balanceCost.secondResource());
+      writer.int32(balanceCost.target());
+      writer.int32(balanceCost.weight());
+   }
+
+   for (int i = 0; i < instance.numProcesses(); i++)
+      writer.int32(instance.initAssignment()[i]);
+
+   std::vector<char> const & payload = writer.payload();
+
+   Header header;
+   std::memcpy(header.magic, magic, sizeof(magic));
+   header.byteOrderMark = byteOrderMark;
+   header.version = version;
+   header.reserved = 0;
+   header.payloadSize = payload.size();
+   header.checksum = checksum(&payload[0], payload.size());
+
+   std::ofstream file(filename.c_str(), std::ios::binary);
+   file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+   file.write(&payload[0], payload.size());
+
+   if (!file)
+      throw BadFormat("cannot write " + filename);
+}
+
+inst::Instance* BinaryInstance::load(std::string const & filename)
+{
+   MappedFile mappedFile(filename);
+
+   if (mappedFile.size() < sizeof(Header))
+      throw BadFormat("truncated header");
+
+   Header header;
+   std::memcpy(&header, mappedFile.data(), sizeof(header));
+
+   if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+      throw BadFormat("not a precompiled instance");
+
+   if (header.byteOrderMark != byteOrderMark)
+      throw BadFormat("precompiled instance with a foreign byte order");
+
+   if (header.version != version)
+      throw BadFormat("unsupported precompiled instance version");
+
+   char const * payload = mappedFile.data() + sizeof(Header);
+
+   if (header.payloadSize != mappedFile.size() - sizeof(Header)
+       || header.payloadSize % 8 != 0)
+      throw BadFormat("truncated payload");
+
+   if (header.checksum != checksum(payload, header.payloadSize))
+      throw BadFormat("checksum mismatch");
+
+   Reader reader(payload, header.payloadSize);
+
+   // The counts are checked against the smallest size of their items,
+   // so that a bad count can't make the vectors below allocate more
+   // than the file could describe.
+   int numResources = reader.count(8);
+   int numMachines = reader.count(8 + 16 * static_cast<uint64_t>(
+                                     numResources));
+   int numServices = reader.count(8);
+   int numProcesses = reader.count(12 + 8 * static_cast<uint64_t>(
+                                      numResources));
+   int numBalanceCosts = reader.count(16);
+   int numNeighborhoods = reader.count(0);
+   int numLocations = reader.count(0);
+
+   // Every neighborhood and location has a machine.
+   if (numNeighborhoods > numMachines || numLocations > numMachines)
+      throw BadFormat("invalid count");
+
+   int processMoveCostWeight = reader.int32();
+   int serviceMoveCostWeight = reader.int32();
+   int machineMoveCostWeight = reader.int32();
+
+   std::vector<inst::Resource> resources;
+   std::vector<inst::Machine> machines;
+   std::vector<inst::Service> services;
+   std::vector<inst::Process> processes;
+   std::vector<inst::BalanceCost> balanceCosts;
+   std::vector<int> initAssignment;
+
+   resources.reserve(numResources);
+   machines.reserve(numMachines);
+   services.reserve(numServices);
+   processes.reserve(numProcesses);
+   balanceCosts.reserve(numBalanceCosts);
+   initAssignment.reserve(numProcesses);
+
+   for (int i = 0; i < numResources; i++)
+   {
+      bool transient = reader.int32();
+      int loadCostWeight = reader.int32();
+
+      resources.push_back(inst::Resource(i, transient, loadCostWeight));
+   }
+
+   std::vector<int> neighborhoods(numMachines);
+   std::vector<int> locations(numMachines);
+   std::vector<std::vector<inst::integer> > capacities(numMachines);
+   std::vector<std::vector<inst::integer> > safetyCapacities(numMachines);
+
+   for (int i = 0; i < numMachines; i++)
+   {
+      neighborhoods[i] = reader.index(numNeighborhoods, "neighborhood");
+      locations[i] = reader.index(numLocations, "location");
+
+      capacities[i].reserve(numResources);
+      safetyCapacities[i].reserve(numResources);
+
+      reader.fillArray<int64_t>(numResources,
+                                std::back_inserter(capacities[i]));
+      reader.fillArray<int64_t>(numResources,
+                                std::back_inserter(safetyCapacities[i]));
+   }
+
+   int moveCostWidth = reader.int32();
+
+   if (moveCostWidth != 1 && moveCostWidth != 2 && moveCostWidth != 4
+       && moveCostWidth != 8)
+      throw BadFormat("invalid move cost width");
+
+   if (numMachines > 0
+       && static_cast<uint64_t>(numMachines)
+       > reader.remaining() / numMachines / moveCostWidth)
+      throw BadFormat("truncated payload");
+
+   boost::shared_ptr<inst::MoveCostMatrix const> moveCosts(
+      new inst::MoveCostMatrix(
+         numMachines, moveCostWidth,
+         reader.bytes(static_cast<uint64_t>(numMachines) * numMachines
+                      * moveCostWidth)));
+
+   for (int i = 0; i < numMachines; i++)
+   {
+      machines.push_back(inst::Machine(i, neighborhoods[i], locations[i],
+                                       capacities[i], safetyCapacities[i],
+                                       moveCosts));
+   }
+
+   std::vector<std::vector<int> > reverseDependencies(numServices);
+
+   for (int i = 0; i < numServices; i++)
+   {
+      int spreadMin = reader.int32();
+      int numDependencies = reader.count(4);
+      std::vector<int> dependencies;
+
+      reader.fillArray<int32_t>(numDependencies,
+                                std::back_inserter(dependencies));
+
+      for (int j = 0; j < dependencies.size(); j++)
+      {
+         if (dependencies[j] < 0 || dependencies[j] >= numServices)
+            throw BadFormat("invalid service dependency");
+
+         reverseDependencies[dependencies[j]].push_back(i);
+      }
+
+      services.push_back(inst::Service(i, spreadMin, dependencies));
+   }
+
+   for (int i = 0; i < numServices; i++)
+   {
+      services[i].setReverseDependencies(reverseDependencies[i]);
+   }
+
+   for (int i = 0; i < numProcesses; i++)
+   {
+      int service = reader.index(numServices, "process service");
+      int moveCost = reader.int32();
+      std::vector<inst::integer> requirements;
+
+      requirements.reserve(numResources);
+      reader.fillArray<int64_t>(numResources,
+                                std::back_inserter(requirements));
+
+      processes.push_back(inst::Process(i, service, requirements, moveCost));
+   }
+
+   for (int i = 0; i < numBalanceCosts; i++)
+   {
+      int firstResource = reader.index(numResources, "balance resource");
+      int secondResource = reader.index(numResources, "balance resource");
+      int target = reader.int32();
+      int weight = reader.int32();
+
+      balanceCosts.push_back(inst::BalanceCost(i, firstResource,
+                                               secondResource,
+                                               target, weight));
+   }
+
+   for (int i = 0; i < numProcesses; i++)
+      initAssignment.push_back(reader.index(numMachines, "initial machine"));
+
+   return new inst::Instance(
+      resources,
+      machines,
+      moveCosts,
+      services,
+      processes,
+      balanceCosts,
+      initAssignment,
+      processMoveCostWeight,
+      serviceMoveCostWeight,
+      machineMoveCostWeight,
+      numNeighborhoods,
+      numLocations);
+}
+
+// 64-bit FNV-1a applied to whole words rather than bytes.
+unsigned long long BinaryInstance::checksum(char const * data,
+                                            unsigned long long size)
+{
+   uint64_t hash = 14695981039346656037ULL;
+
+   for (unsigned long long i = 0; i + 8 <= size; i += 8)
+   {
+      uint64_t word;
+      std::memcpy(&word, data + i, sizeof(word));
+
+      hash ^= word;
+      hash *= 1099511628211ULL;
+   }
+
+   return hash;
+}
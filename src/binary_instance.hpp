@@ -0,0 +1,46 @@
+#ifndef BINARY_INSTANCE_HPP
+#define BINARY_INSTANCE_HPP
+
+#include "instance.hpp"
+
+#include <stdexcept>
+#include <string>
+
+// Precompiled instances: the parsed model and initial assignment are
+// written as fixed-width arrays in the native byte order, preceded by a
+// header (magic, byte order mark, format version, payload size and
+// checksum). A file written with another byte order is rejected.
+// Loading maps the file in memory and copies the arrays out of the
+// mapping into the instance, so there is no text parsing.
+class BinaryInstance
+{
+public:
+
+   class BadFormat : public std::runtime_error
+   {
+   public:
+      BadFormat(std::string const & what)
+         : std::runtime_error(what)
+      {
+      }
+   };
+
+   static const unsigned int version = 3;
+
+   // Returns true if the file starts with the precompiled instance magic.
+   static bool isBinary(std::string const & filename);
+
+   static void write(inst::Instance const & instance,
+                     std::string const & filename);
+
+   // Throws BadFormat if the file is truncated, has the wrong byte
+   // order or version, doesn't match its checksum, or has a count or
+   // an index out of range.
+   static inst::Instance* load(std::string const & filename);
+
+private:
+   static unsigned long long checksum(char const * data,
+                                      unsigned long long size);
+};
+
+#endif
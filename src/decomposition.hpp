@@ -0,0 +1,327 @@
+#ifndef DECOMPOSITION_HPP
+#define DECOMPOSITION_HPP
+
+#include "hill_climbing.hpp"
+#include "instance.hpp"
+#include "pool.hpp"
+#include "solution.hpp"
+#include "thread_team.hpp"
+
+#include <algorithm>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+// A local search which splits the machines into disjoint clusters and
+// runs a HillClimbing on each of them, only moving the processes of the
+// cluster to the machines of the cluster. The clusters are shared by
+// the threads of a team: each thread copies the solution once per step
+// and searches its clusters one after the other on its copy.
+//
+// The moves of the clusters are then replayed on the solution, one
+// cluster after the other. Each replayed move is checked and evaluated
+// again against the solution, where the processes of the other
+// clusters have moved: this reconciles the terms which span the
+// clusters (the service move maximum, the spread and the dependency
+// counts). A move which isn't feasible yet is tried again once the
+// other moves of its cluster are replayed, and the moves of a cluster
+// are rolled back if, all together, they don't improve the solution.
+template <typename Solution>
+class Decomposition
+{
+public:
+   // The clusters are made of whole neighborhoods if there are enough
+   // of them, of whole locations otherwise, and are run by numThreads
+   // threads. They share the relocation costs budget.
+   Decomposition(unsigned int seed, inst::Instance const & instance,
+                 Pool * pool, int numClusters, int numProcesses,
+                 int numMachines, int numTriesMax,
+                 std::size_t relocationCostsBudget, int numThreads)
+      : _inst(instance),
+        _pool(pool),
+        _clusterMachines(clusterMachines(instance, numClusters)),
+        _machineClusters(instance.numMachines()),
+        _clusterProcesses(_clusterMachines.size()),
+        _numReplayedMoves(0),
+        _numDroppedMoves(0),
+        _stop(false),
+        _team(numThreads)
+   {
+      for (int i = 0; i < _clusterMachines.size(); i++)
+      {
+         for (int j = 0; j < _clusterMachines[i].size(); j++)
+            _machineClusters[_clusterMachines[i][j]] = i;
+
+         // The solutions of the clusters aren't added to any pool:
+         // only the replayed one is.
+         _localSearches.push_back(boost::shared_ptr<HillClimbing>(
+                                     new HillClimbing(
+                                        seed + i, instance,
+                                        0,
+                                        numProcesses, numMachines,
+                                        numTriesMax,
+                                        relocationCostsBudget
+                                        / _clusterMachines.size())));
+         _localSearches.back()->setStopFlag(&_stop);
+      }
+   }
+
+   int numClusters() const
+   {
+      return _clusterMachines.size();
+   }
+
+   // Improves the solution in place.
+   void apply(Solution & solution)
+   {
+      for (int i = 0; i < numClusters(); i++)
+         _clusterProcesses[i].clear();
+
+      for (int i = 0; i < _inst.numProcesses(); i++)
+      {
+         int machine = solution.assignment()[i];
+         _clusterProcesses[_machineClusters[machine]].push_back(i);
+      }
+
+      while (_memberSolutions.size() < _team.size())
+         _memberSolutions.push_back(solution);
+
+      // The calling thread can't be interrupted during the run: it
+      // stops the clusters through _stop instead, and is interrupted
+      // once the other threads are done.
+      Job job = { this, &solution };
+      _stop = false;
+      _team.run(&Job::run, &job);
+
+      bool improved = false;
+
+      for (int i = 0; i < numClusters(); i++)
+         improved |= replay(solution, i);
+
+      if (improved)
+         _pool->addSolution(solution);
+
+      boost::this_thread::interruption_point();
+   }
+
+   unsigned long long numEvaluatedMoves() const
+   {
+      unsigned long long numEvaluatedMoves = 0;
+
+      for (int i = 0; i < _localSearches.size(); i++)
+         numEvaluatedMoves += _localSearches[i]->numEvaluatedMoves();
+
+      return numEvaluatedMoves;
+   }
+
+   unsigned long long numBoundedMoves() const
+   {
+      unsigned long long numBoundedMoves = 0;
+
+      for (int i = 0; i < _localSearches.size(); i++)
+         numBoundedMoves += _localSearches[i]->numBoundedMoves();
+
+      return numBoundedMoves;
+   }
+
+   // Number of moves of the clusters evaluated again on the solution,
+   // and number of those which were not kept.
+   unsigned long long numStaleMoves() const
+   {
+      return _numReplayedMoves;
+   }
+
+   unsigned long long numConflicts() const
+   {
+      return _numDroppedMoves;
+   }
+
+private:
+   struct Job
+   {
+      Decomposition * decomposition;
+      Solution * solution;
+
+      static void run(void * context, int member)
+      {
+         Job * job = static_cast<Job *>(context);
+         job->decomposition->search(*job->solution, member);
+      }
+   };
+
+   static std::vector<std::vector<int> > clusterMachines(
+      inst::Instance const & instance, int numClusters)
+   {
+      // Group of each machine.
+      std::vector<int> groups(instance.numMachines());
+      int numGroups;
+
+      if (instance.numNeighborhoods() >= numClusters)
+      {
+         numGroups = instance.numNeighborhoods();
+
+         for (int i = 0; i < instance.numMachines(); i++)
+            groups[i] = instance.machine(i).neighborhood();
+      }
+      else
+      {
+         numGroups = instance.numLocations();
+
+         for (int i = 0; i < instance.numMachines(); i++)
+            groups[i] = instance.machine(i).location();
+      }
+
+      numClusters = std::max(1, std::min(numClusters, numGroups));
+
+      std::vector<std::pair<int, int> > groupSizes(numGroups);
+
+      for (int i = 0; i < numGroups; i++)
+         groupSizes[i] = std::make_pair(0, i);
+
+      for (int i = 0; i < instance.numMachines(); i++)
+         groupSizes[groups[i]].first++;
+
+      // The largest groups first, each to the smallest cluster.
+      std::sort(groupSizes.rbegin(), groupSizes.rend());
+
+      std::vector<int> clusterSizes(numClusters, 0);
+      std::vector<int> groupClusters(numGroups);
+
+      for (int i = 0; i < numGroups; i++)
+      {
+         int cluster = std::min_element(clusterSizes.begin(),
+                                        clusterSizes.end())
+            - clusterSizes.begin();
+
+         groupClusters[groupSizes[i].second] = cluster;
+         clusterSizes[cluster] += groupSizes[i].first;
+      }
+
+      std::vector<std::vector<int> > clusters(numClusters);
+
+      for (int i = 0; i < instance.numMachines(); i++)
+         clusters[groupClusters[groups[i]]].push_back(i);
+
+      // A cluster without machines would have nothing to search.
+      clusters.erase(std::remove_if(clusters.begin(), clusters.end(),
+                                    isEmpty),
+                     clusters.end());
+
+      return clusters;
+   }
+
+   static bool isEmpty(std::vector<int> const & machines)
+   {
+      return machines.empty();
+   }
+
+   // Searches the clusters member, member + numThreads, ... on the copy
+   // of the member.
+   void search(Solution const & solution, int member)
+   {
+      if (member >= numClusters())
+         return;
+
+      // Copied even if stopped, since the clusters are all replayed.
+      Solution & memberSolution = _memberSolutions[member];
+      memberSolution = solution;
+
+      for (int i = member; i < numClusters() && !_stop.load();
+           i += _team.size())
+      {
+         if (_clusterProcesses[i].empty())
+            continue;
+
+         _localSearches[i]->restrict(_clusterProcesses[i],
+                                     _clusterMachines[i]);
+         _localSearches[i]->apply(memberSolution);
+      }
+   }
+
+   // Moves the processes of the cluster to their machines in the copy
+   // of its member. Returns true if the solution is improved.
+   bool replay(Solution & solution, int cluster)
+   {
+      std::vector<int> & moved = _movedProcesses;
+      Solution const & clusterSolution
+         = _memberSolutions[cluster % _team.size()];
+
+      moved.clear();
+
+      for (int i = 0; i < _clusterProcesses[cluster].size(); i++)
+      {
+         int process = _clusterProcesses[cluster][i];
+
+         if (clusterSolution.assignment()[process]
+             != solution.assignment()[process])
+            moved.push_back(process);
+      }
+
+      if (moved.empty())
+         return false;
+
+      _numReplayedMoves += moved.size();
+
+      typename Solution::Checkpoint checkpoint = solution.checkpoint();
+      inst::integer value = solution.objValue().objValue();
+      int numMoved;
+
+      // A move can need another one to free its destination first.
+      do
+      {
+         numMoved = 0;
+
+         for (int i = 0; i < moved.size(); i++)
+         {
+            int process = moved[i];
+            int machine = clusterSolution.assignment()[process];
+
+            if (!solution.isFeasible(process, machine))
+            {
+               moved[i - numMoved] = process;
+               continue;
+            }
+
+            solution.moveProcess(process, machine,
+                                 solution.evaluateFeasibleMove(process,
+                                                               machine));
+            numMoved++;
+         }
+
+         moved.resize(moved.size() - numMoved);
+      }
+      while (numMoved > 0 && !moved.empty());
+
+      _numDroppedMoves += moved.size();
+
+      if (solution.objValue().objValue() < value)
+         return true;
+
+      _numDroppedMoves += solution.checkpoint() - checkpoint;
+      solution.rollback(checkpoint);
+      return false;
+   }
+
+   inst::Instance const & _inst;
+   Pool * _pool;
+
+   std::vector<std::vector<int> > _clusterMachines;
+   std::vector<int> _machineClusters; // machine -> cluster
+   std::vector<std::vector<int> > _clusterProcesses;
+   std::vector<Solution> _memberSolutions;
+
+   std::vector<boost::shared_ptr<HillClimbing> > _localSearches;
+
+   std::vector<int> _movedProcesses;
+   unsigned long long _numReplayedMoves;
+   unsigned long long _numDroppedMoves;
+
+   boost::atomic<bool> _stop;
+
+   // Declared last: its threads are stopped before the rest is
+   // destroyed.
+   ThreadTeam _team;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef HASH_COUNTER_HPP
+#define HASH_COUNTER_HPP
+
+#include <stdint.h>
+#include <vector>
+
+// Counts occurrences of 64-bit keys in an open addressing table (linear
+// probing, backward shift deletion). Only the keys with a non-zero
+// count are stored, and the table never grows: it is sized for
+// maxNumKeys distinct keys at a load factor of at most one half.
+class HashCounter
+{
+public:
+   HashCounter(int maxNumKeys)
+      : _mask(capacityFor(maxNumKeys) - 1),
+        _entries(_mask + 1)
+   {
+   }
+
+   int count(uint64_t key) const
+   {
+      for (uint64_t i = slot(key); ; i = (i + 1) & _mask)
+      {
+         Entry const & entry = _entries[i];
+
+         if (entry.key == key)
+            return entry.count;
+
+         if (entry.key == emptyKey)
+            return 0;
+      }
+   }
+
+   void increment(uint64_t key)
+   {
+      uint64_t i = slot(key);
+
+      while (_entries[i].key != key && _entries[i].key != emptyKey)
+         i = (i + 1) & _mask;
+
+      _entries[i].key = key;
+      _entries[i].count++;
+   }
+
+   // The key must have a positive count.
+   void decrement(uint64_t key)
+   {
+      uint64_t i = slot(key);
+
+      while (_entries[i].key != key)
+         i = (i + 1) & _mask;
+
+      if (--_entries[i].count == 0)
+         erase(i);
+   }
+
+private:
+   static const uint64_t emptyKey = ~static_cast<uint64_t>(0);
+
+   struct Entry
+   {
+      Entry() : key(emptyKey), count(0) {}
+
+      uint64_t key;
+      int count;
+   };
+
+   static uint64_t capacityFor(int maxNumKeys)
+   {
+      uint64_t capacity = 16;
+
+      while (capacity < 2 * static_cast<uint64_t>(maxNumKeys))
+         capacity *= 2;
+
+      return capacity;
+   }
+
+   uint64_t slot(uint64_t key) const
+   {
+      // Fibonacci hashing: the high bits of the product are the best
+      // mixed, fold them down.
+      uint64_t hash = key * 0x9E3779B97F4A7C15ULL;
+      return (hash ^ (hash >> 32)) & _mask;
+   }
+
+   // Shift back the entries following the hole so that every key stays
+   // reachable from its slot without tombstones.
+   void erase(uint64_t hole)
+   {
+      uint64_t i = hole;
+
+      while (true)
+      {
+         i = (i + 1) & _mask;
+
+         if (_entries[i].key == emptyKey)
+            break;
+
+         uint64_t home = slot(_entries[i].key);
+
+         // Move the entry if its home slot isn't in (hole, i].
+         if (((i - home) & _mask) >= ((i - hole) & _mask))
+         {
+            _entries[hole] = _entries[i];
+            hole = i;
+         }
+      }
+
+      _entries[hole] = Entry();
+   }
+
+   uint64_t _mask;
+   std::vector<Entry> _entries;
+};
+
+#endif
@@ -3,11 +3,17 @@
 
 #include "instance.hpp"
 #include "pool.hpp"
+#include "relocation_costs.hpp"
 #include "solution.hpp"
+#include "thread_team.hpp"
 
 #include <algorithm>
 #include <limits>
+#include <boost/atomic.hpp>
 #include <boost/iterator/counting_iterator.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int.hpp>
@@ -16,66 +22,88 @@
 class HillClimbing
 {
 public:
-   HillClimbing(unsigned int seed, inst::Instance const & instance, 
+   // The processes of a step are scanned by numScanThreads threads,
+   // each with its own relocation cost cache, which share the budget.
+   // With concurrentMoves, each of these threads makes its own steps
+   // on the solution instead (see applyConcurrently()). The improved
+   // solutions are added to the pool, if any.
+   HillClimbing(unsigned int seed, inst::Instance const & instance,
                 Pool * pool, int numProcesses, int numMachines,
-                int numTriesMax)
+                int numTriesMax, std::size_t relocationCostsBudget,
+                int numScanThreads = 1, bool concurrentMoves = false)
       : _inst(instance),
         _pool(pool),
+        _maxNumMachines(0),
+        _maxNumProcesses(0),
         _numMachines(0),
         _numProcesses(0),
-        _machines(boost::counting_iterator<int>(0),
-                  boost::counting_iterator<int>(_inst.numMachines())),
         _processes(boost::counting_iterator<int>(0),
                    boost::counting_iterator<int>(_inst.numProcesses())),
         _gen(seed),
         _rng(_gen, _dist),
-        _numTriesMax(numTriesMax)
+        _numTriesMax(numTriesMax),
+        _numEvaluatedMoves(0),
+        _numBoundedMoves(0),
+        _numStaleMoves(0),
+        _numConflicts(0),
+        _concurrentMoves(concurrentMoves),
+        _version(0),
+        _numTries(0),
+        _stop(false),
+        _stopFlag(0),
+        _team(numScanThreads)
    {
+      for (int i = 0; i < _team.size(); i++)
+      {
+         _scanners.push_back(boost::shared_ptr<Scanner>(
+                                new Scanner(seed + i + 1, instance,
+                                            relocationCostsBudget
+                                            / _team.size())));
+      }
+
       setNumMachines(numMachines);
       setNumProcesses(numProcesses);
    }
 
-   sol::Solution apply(sol::Solution const & solution)
+   // Improves the solution in place.
+   template <typename Solution>
+   void apply(Solution & currentSolution)
    {
+      if (_concurrentMoves && _team.size() > 1)
+      {
+         applyConcurrently(currentSolution);
+         return;
+      }
+
       inst::integer bestValue;
       std::pair<int, int> bestMove;
       sol::ObjValue bestDeltaObjValue;
-      sol::Solution currentSolution(solution);
       int numTries = 0;
 
+      ScanJob<Solution> job = { this, &currentSolution };
+
       do
       {
-         bestValue = std::numeric_limits<inst::integer>::max();
-
          shuffleProcesses();
 
-         for (int i = 0; i < _numProcesses; i++)
+         _team.run(&ScanJob<Solution>::run, &job);
+
+         // The slices are reduced in order, so that a tie goes to the
+         // move a serial scan would have kept.
+         bestValue = std::numeric_limits<inst::integer>::max();
+
+         for (int i = 0; i < _scanners.size(); i++)
          {
-            int process = _processes[i];
+            Scanner const & scanner = *_scanners[i];
 
-            shuffleMachines();
+            _numEvaluatedMoves += scanner.numEvaluatedMoves;
+            _numBoundedMoves += scanner.numBoundedMoves;
 
-            for (int j = 0; j < _numMachines; j++)
+            if (scanner.bestValue < bestValue)
             {
-               int machine = _machines[j];
-
-               if (currentSolution.assignment()[process] == machine)
-                  continue;
-
-               if (!currentSolution.isFeasible(process, machine))
-                  continue;
-               
-               sol::ObjValue deltaObjValue(
-                  currentSolution.evaluateFeasibleMove(process, machine));
-
-               inst::integer value = deltaObjValue.objValue();
-               
-               if (value < bestValue)
-               {
-                  bestValue = value;
-                  bestMove = std::make_pair(process, machine);
-                  bestDeltaObjValue = deltaObjValue;
-               }
+               bestValue = scanner.bestValue;
+               bestMove = scanner.bestMove;
+               bestDeltaObjValue = scanner.bestDeltaObjValue;
             }
          }
 
@@ -83,7 +111,10 @@ public:
          {
             currentSolution.moveProcess(bestMove.first, bestMove.second,
                                   bestDeltaObjValue);
-            _pool->addSolution(currentSolution);
+
+            if (_pool)
+               _pool->addSolution(currentSolution);
+
             numTries = 0;
          }
          else
@@ -91,30 +122,376 @@ public:
             numTries++;
          }
 
+         if (stopRequested())
+            return;
+
          boost::this_thread::interruption_point();
       }
       while(bestValue < 0 || numTries < _numTriesMax);
+   }
+
+   // Number of (process, machine) moves checked so far.
+   unsigned long long numEvaluatedMoves() const
+   {
+      return _numEvaluatedMoves;
+   }
 
+   // Number of these moves whose evaluation was cut short because they
+   // couldn't beat the best move.
+   unsigned long long numBoundedMoves() const
+   {
+      return _numBoundedMoves;
+   }
 
-      return currentSolution;
+   // With concurrent moves, number of moves evaluated again because
+   // another thread moved a process since their evaluation, and
+   // number of those which no longer improved the solution.
+   unsigned long long numStaleMoves() const
+   {
+      return _numStaleMoves;
+   }
+
+   unsigned long long numConflicts() const
+   {
+      return _numConflicts;
    }
 
    void setNumMachines(int numMachines)
    {
-      _numMachines = std::min(numMachines, _inst.numMachines());
+      _maxNumMachines = numMachines;
+      _numMachines = std::min<int>(numMachines,
+                                   _scanners.front()->machines.size());
    }
 
    void setNumProcesses(int numProcesses)
    {
-      _numProcesses = std::min(numProcesses, _inst.numProcesses());
+      _maxNumProcesses = numProcesses;
+      _numProcesses = std::min<int>(numProcesses, _processes.size());
+   }
+
+   // Only moves the given processes, and only to the given machines,
+   // which must include their current ones.
+   void restrict(std::vector<int> const & processes,
+                 std::vector<int> const & machines)
+   {
+      _processes.assign(processes.begin(), processes.end());
+
+      for (int i = 0; i < _scanners.size(); i++)
+      {
+         _scanners[i]->processes.assign(processes.begin(), processes.end());
+         _scanners[i]->machines.assign(machines.begin(), machines.end());
+      }
+
+      setNumMachines(_maxNumMachines);
+      setNumProcesses(_maxNumProcesses);
    }
 
+   // Makes apply() return between two steps once the flag is set. The
+   // hill climbing sets it itself when its thread is interrupted, which
+   // lets a thread that can't be interrupted stop the other ones.
+   void setStopFlag(boost::atomic<bool> * stop)
+   {
+      _stopFlag = stop;
+   }
 
 private:
 
-   void shuffleMachines()
+   // What a thread of the scan owns: its order of the machines, its
+   // random generator, its relocation cost cache and buffers, and the
+   // best move among the processes of its slice.
+   struct Scanner
    {
-      std::random_shuffle(_machines.begin(), _machines.end(), _rng);
+      Scanner(unsigned int seed, inst::Instance const & instance,
+              std::size_t relocationCostsBudget)
+         : processes(boost::counting_iterator<int>(0),
+                     boost::counting_iterator<int>(instance.numProcesses())),
+           machines(boost::counting_iterator<int>(0),
+                    boost::counting_iterator<int>(instance.numMachines())),
+           gen(seed),
+           rng(gen, dist),
+           relocationCosts(instance, relocationCostsBudget),
+           candidates(instance.numMachines()),
+           evaluations(instance.numMachines())
+      {
+      }
+
+      // The order of the processes is only used by concurrent moves.
+      std::vector<int> processes;
+      std::vector<int> machines;
+
+      boost::mt19937 gen;
+      boost::uniform_int<> dist;
+      boost::variate_generator<boost::mt19937&, boost::uniform_int<> > rng;
+
+      RelocationCosts relocationCosts;
+
+      // The machines a process is evaluated against, and the outcomes.
+      std::vector<int> candidates;
+      std::vector<sol::MoveEvaluation> evaluations;
+
+      inst::integer bestValue;
+      std::pair<int, int> bestMove;
+      sol::ObjValue bestDeltaObjValue;
+      unsigned long long numEvaluatedMoves;
+      unsigned long long numBoundedMoves;
+      unsigned long long numStaleMoves;
+      unsigned long long numConflicts;
+   };
+
+   template <typename Solution>
+   struct ScanJob
+   {
+      HillClimbing * hillClimbing;
+      Solution * solution;
+
+      static void run(void * context, int member)
+      {
+         ScanJob * job = static_cast<ScanJob *>(context);
+         job->hillClimbing->scanSlice(*job->solution, member);
+      }
+   };
+
+   template <typename Solution>
+   struct SearchJob
+   {
+      HillClimbing * hillClimbing;
+      Solution * solution;
+
+      static void run(void * context, int member)
+      {
+         SearchJob * job = static_cast<SearchJob *>(context);
+         job->hillClimbing->search(*job->solution, member);
+      }
+   };
+
+   // Every thread of the team makes its own steps on the solution:
+   // the moves are evaluated under a shared lock, and the best move
+   // of a step is applied under an exclusive one. Each move applied
+   // increments the version of the solution; if the version changed
+   // since a move was evaluated, the move is evaluated again before
+   // being applied, since its delta may depend on the machines,
+   // services and locations touched by the other moves, as well as on
+   // the service move maximum.
+   template <typename Solution>
+   void applyConcurrently(Solution & currentSolution)
+   {
+      SearchJob<Solution> job = { this, &currentSolution };
+
+      _numTries = 0;
+      _stop = false;
+      _team.run(&SearchJob<Solution>::run, &job);
+
+      for (int i = 0; i < _scanners.size(); i++)
+      {
+         Scanner const & scanner = *_scanners[i];
+
+         _numEvaluatedMoves += scanner.numEvaluatedMoves;
+         _numBoundedMoves += scanner.numBoundedMoves;
+         _numStaleMoves += scanner.numStaleMoves;
+         _numConflicts += scanner.numConflicts;
+      }
+
+      boost::this_thread::interruption_point();
+   }
+
+   // The hill climbing of a thread with concurrent moves. Each step
+   // scans the share of the processes of the thread. The threads stop
+   // together, once none of their last numTriesMax steps each made a
+   // move.
+   template <typename Solution>
+   void search(Solution & currentSolution, int member)
+   {
+      Scanner & scanner = *_scanners[member];
+      int numProcesses = std::max(1, _numProcesses / _team.size());
+      int numTriesMax = _numTriesMax * _team.size();
+
+      unsigned long long numEvaluatedMoves = 0;
+      unsigned long long numBoundedMoves = 0;
+
+      scanner.numStaleMoves = 0;
+      scanner.numConflicts = 0;
+
+      while (_numTries.load() < numTriesMax && !_stop.load())
+      {
+         std::random_shuffle(scanner.processes.begin(),
+                             scanner.processes.end(), scanner.rng);
+
+         unsigned long long version;
+
+         {
+            boost::shared_lock<boost::shared_mutex> lock(_mutex);
+            version = _version;
+            scan(currentSolution, scanner, &scanner.processes[0],
+                 numProcesses);
+         }
+
+         numEvaluatedMoves += scanner.numEvaluatedMoves;
+         numBoundedMoves += scanner.numBoundedMoves;
+
+         if (scanner.bestValue < 0
+             && commit(currentSolution, scanner, version))
+            _numTries = 0;
+         else
+            _numTries++;
+
+         // Only the calling thread can be interrupted.
+         if (member == 0 && boost::this_thread::interruption_requested())
+            _stop = true;
+      }
+
+      scanner.numEvaluatedMoves = numEvaluatedMoves;
+      scanner.numBoundedMoves = numBoundedMoves;
+   }
+
+   // Applies the best move of the scanner, false if it no longer
+   // improves the solution.
+   template <typename Solution>
+   bool commit(Solution & currentSolution, Scanner & scanner,
+               unsigned long long version)
+   {
+      boost::unique_lock<boost::shared_mutex> lock(_mutex);
+
+      int process = scanner.bestMove.first;
+      int machine = scanner.bestMove.second;
+      sol::ObjValue deltaObjValue = scanner.bestDeltaObjValue;
+
+      if (_version != version)
+      {
+         scanner.numStaleMoves++;
+
+         sol::MoveEvaluation evaluation;
+
+         if (currentSolution.assignment()[process] != machine)
+         {
+            currentSolution.evaluateProcessAgainst(
+               process, scanner.relocationCosts.row(process), &machine, 1,
+               &evaluation, 0);
+         }
+         else
+         {
+            evaluation.status = sol::MoveEvaluation::infeasible;
+         }
+
+         if (evaluation.status != sol::MoveEvaluation::evaluated
+             || evaluation.deltaObjValue.objValue() >= 0)
+         {
+            scanner.numConflicts++;
+            return false;
+         }
+
+         deltaObjValue = evaluation.deltaObjValue;
+      }
+
+      currentSolution.moveProcess(process, machine, deltaObjValue);
+      _version++;
+
+      if (_pool)
+         _pool->addSolution(currentSolution);
+
+      return true;
+   }
+
+   // Scans the slice of the processes of a thread.
+   template <typename Solution>
+   void scanSlice(Solution & currentSolution, int member)
+   {
+      int begin = static_cast<long long>(_numProcesses) * member
+         / _team.size();
+      int end = static_cast<long long>(_numProcesses) * (member + 1)
+         / _team.size();
+
+      scan(currentSolution, *_scanners[member], &_processes[begin],
+           end - begin);
+   }
+
+   // Keeps the best move of the processes in the scanner. The solution
+   // is only read.
+   template <typename Solution>
+   void scan(Solution & currentSolution, Scanner & scanner,
+             int const * processes, int numProcesses)
+   {
+      inst::integer bestValue = std::numeric_limits<inst::integer>::max();
+      unsigned long long numEvaluatedMoves = 0;
+      unsigned long long numBoundedMoves = 0;
+
+      for (int i = 0; i < numProcesses; i++)
+      {
+         int process = processes[i];
+
+         std::random_shuffle(scanner.machines.begin(),
+                             scanner.machines.end(), scanner.rng);
+
+         inst::integer const * relocationCosts
+            = scanner.relocationCosts.row(process);
+         int srcMachine = currentSolution.assignment()[process];
+         inst::integer srcRelocationCost = relocationCosts[srcMachine];
+         int numCandidates = 0;
+
+         // The machines where the process and machine move costs don't
+         // increase are evaluated first: the best move is more likely
+         // among them, and the sooner it is found, the more moves are
+         // bounded.
+         for (int j = 0; j < _numMachines; j++)
+         {
+            int machine = scanner.machines[j];
+
+            if (machine != srcMachine
+                && relocationCosts[machine] <= srcRelocationCost)
+               scanner.candidates[numCandidates++] = machine;
+         }
+
+         for (int j = 0; j < _numMachines; j++)
+         {
+            int machine = scanner.machines[j];
+
+            if (relocationCosts[machine] > srcRelocationCost)
+               scanner.candidates[numCandidates++] = machine;
+         }
+
+         numEvaluatedMoves += numCandidates;
+
+         // Only the moves which can beat the best one are evaluated in
+         // full.
+         currentSolution.evaluateProcessAgainst(
+            process, relocationCosts, &scanner.candidates[0],
+            numCandidates, &scanner.evaluations[0], bestValue);
+
+         for (int j = 0; j < numCandidates; j++)
+         {
+            sol::MoveEvaluation const & evaluation = scanner.evaluations[j];
+
+            if (evaluation.status == sol::MoveEvaluation::bounded)
+               numBoundedMoves++;
+
+            if (evaluation.status != sol::MoveEvaluation::evaluated)
+               continue;
+
+            inst::integer value = evaluation.deltaObjValue.objValue();
+
+            if (value < bestValue)
+            {
+               bestValue = value;
+               scanner.bestMove = std::make_pair(process,
+                                                 scanner.candidates[j]);
+               scanner.bestDeltaObjValue = evaluation.deltaObjValue;
+            }
+         }
+      }
+
+      scanner.bestValue = bestValue;
+      scanner.numEvaluatedMoves = numEvaluatedMoves;
+      scanner.numBoundedMoves = numBoundedMoves;
+   }
+
+   bool stopRequested()
+   {
+      if (_stopFlag == 0)
+         return false;
+
+      if (boost::this_thread::interruption_requested())
+         *_stopFlag = true;
+
+      return _stopFlag->load();
    }
 
    void shuffleProcesses()
@@ -124,10 +501,11 @@ private:
 
    inst::Instance const & _inst;
    Pool * _pool;
-   int _numMachines;
-   int _numProcesses;
+   int _maxNumMachines;
+   int _maxNumProcesses;
+   int _numMachines;  // min(_maxNumMachines, number of machines)
+   int _numProcesses; // min(_maxNumProcesses, number of processes)
 
-   std::vector<int> _machines;
    std::vector<int> _processes;
 
    boost::mt19937 _gen;
@@ -136,6 +514,25 @@ private:
    boost::variate_generator<boost::mt19937&, boost::uniform_int<> > _rng;
 
    int _numTriesMax;
+   unsigned long long _numEvaluatedMoves;
+   unsigned long long _numBoundedMoves;
+   unsigned long long _numStaleMoves;
+   unsigned long long _numConflicts;
+
+   // Concurrent moves.
+   bool _concurrentMoves;
+   boost::shared_mutex _mutex;
+   unsigned long long _version;
+   boost::atomic<int> _numTries;
+   boost::atomic<bool> _stop;
+
+   boost::atomic<bool> * _stopFlag;
+
+   std::vector<boost::shared_ptr<Scanner> > _scanners;
+
+   // Declared last: its threads are stopped before the scanners are
+   // destroyed.
+   ThreadTeam _team;
 };
 
 #endif
@@ -1,13 +1,131 @@
 #ifndef MODEL_HPP
 #define MODEL_HPP
 
+#include "aligned_array.hpp"
+
+#include <boost/shared_ptr.hpp>
+#include <cstring>
 #include <set>
+#include <stdexcept>
+#include <stdint.h>
 #include <vector>
 
 namespace inst
 {
    typedef long long int integer;
 
+   // Machine move costs (numMachines x numMachines, row major) stored
+   // contiguously with the narrowest width (1, 2, 4 or 8 bytes) able to
+   // hold every value. The width grows as values are set.
+   class MoveCostMatrix
+   {
+   public:
+      MoveCostMatrix(int numMachines)
+         : _numMachines(numMachines),
+           _width(1),
+           _data(static_cast<size_t>(numMachines) * numMachines, 0)
+      {
+      }
+
+      // data must hold numMachines^2 values of the given width.
+      MoveCostMatrix(int numMachines, int width, unsigned char const * data)
+         : _numMachines(numMachines),
+           _width(width),
+           _data(data, data + static_cast<size_t>(numMachines)
+                 * numMachines * width)
+      {
+      }
+
+      integer moveCost(int srcMachine, int dstMachine) const
+      {
+         size_t index = static_cast<size_t>(srcMachine) * _numMachines
+            + dstMachine;
+         unsigned char const * data = &_data[0];
+
+         switch (_width)
+         {
+         case 1: return data[index];
+         case 2: return load<uint16_t>(data, index);
+         case 4: return load<uint32_t>(data, index);
+         default: return load<int64_t>(data, index);
+         }
+      }
+
+      void setMoveCost(int srcMachine, int dstMachine, integer moveCost)
+      {
+         int width = widthOf(moveCost);
+
+         if (width > _width)
+            widen(width);
+
+         size_t index = static_cast<size_t>(srcMachine) * _numMachines
+            + dstMachine;
+         unsigned char * data = &_data[0];
+
+         switch (_width)
+         {
+         case 1: data[index] = moveCost; break;
+         case 2: store<uint16_t>(data, index, moveCost); break;
+         case 4: store<uint32_t>(data, index, moveCost); break;
+         default: store<int64_t>(data, index, moveCost); break;
+         }
+      }
+
+      int numMachines() const { return _numMachines; }
+
+      // Number of bytes per move cost.
+      int width() const { return _width; }
+
+      std::vector<unsigned char> const & data() const { return _data; }
+
+   private:
+      static int widthOf(integer value)
+      {
+         if (value < 0)
+            return 8;
+         if (value <= 0xFF)
+            return 1;
+         if (value <= 0xFFFF)
+            return 2;
+         if (value <= 0xFFFFFFFFLL)
+            return 4;
+         return 8;
+      }
+
+      template <typename T>
+      static integer load(unsigned char const * data, size_t index)
+      {
+         T value;
+         std::memcpy(&value, data + index * sizeof(T), sizeof(T));
+         return value;
+      }
+
+      template <typename T>
+      static void store(unsigned char * data, size_t index, integer value)
+      {
+         T narrowed = value;
+         std::memcpy(data + index * sizeof(T), &narrowed, sizeof(T));
+      }
+
+      void widen(int width)
+      {
+         MoveCostMatrix widened(_numMachines);
+         widened._width = width;
+         widened._data.resize(_data.size() / _width * width);
+
+         for (int i = 0; i < _numMachines; i++)
+            for (int j = 0; j < _numMachines; j++)
+               widened.setMoveCost(i, j, moveCost(i, j));
+
+         _width = width;
+         _data.swap(widened._data);
+      }
+
+      int _numMachines;
+      int _width;
+      std::vector<unsigned char> _data;
+   };
+
    class Resource
    {
    public:
@@ -32,39 +150,61 @@ namespace inst
    {
    public:
 
+      // The move cost matrix is shared by all the machines, this
+      // machine's costs are the row "id".
       Machine(int id, int neighborhood, int location,
               const std::vector<integer>& capacities,
               const std::vector<integer>& safetyCapacities,
-              const std::vector<integer>& moveCost)
+              boost::shared_ptr<MoveCostMatrix const> const & moveCosts)
          : _id(id),
            _neighborhood(neighborhood),
            _location(location),
-           _capacities(capacities),
-           _safetyCapacities(safetyCapacities),
-           _moveCosts(moveCost)
+           _parsedCapacities(capacities),
+           _parsedSafetyCapacities(safetyCapacities),
+           _capacities(0),
+           _safetyCapacities(0),
+           _moveCosts(moveCosts)
       {
       }
 
       int id() const { return _id; }
       int neighborhood() const { return _neighborhood; }
       int location() const { return _location; }
-      int capacity(int resource) const { return _capacities[resource]; }
-      std::vector<integer> const & capacities() const { return _capacities; }
-      int safetyCapacity(int resource) const
+      integer capacity(int resource) const { return _capacities[resource]; }
+      integer const * capacities() const { return _capacities; }
+      integer safetyCapacity(int resource) const
       { return _safetyCapacities[resource]; }
-      int moveCost(int machine) const { return _moveCosts[machine]; }
+      integer moveCost(int machine) const
+      { return _moveCosts->moveCost(_id, machine); }
 
-      std::vector<integer> const & safetyCapacities() const
+      integer const * safetyCapacities() const
       { return _safetyCapacities; }
 
+      std::vector<integer> const & parsedCapacities() const
+      { return _parsedCapacities; }
+      std::vector<integer> const & parsedSafetyCapacities() const
+      { return _parsedSafetyCapacities; }
+
+      // Called by Instance once the capacities are copied in its
+      // machine x resource arrays.
+      void bindCapacities(integer const * capacities,
+                          integer const * safetyCapacities)
+      {
+         _capacities = capacities;
+         _safetyCapacities = safetyCapacities;
+         std::vector<integer>().swap(_parsedCapacities);
+         std::vector<integer>().swap(_parsedSafetyCapacities);
+      }
 
    private:
       int _id;
       int _neighborhood;
       int _location;
-      std::vector<integer> _capacities;
-      std::vector<integer> _safetyCapacities;
-      std::vector<integer> _moveCosts;
+      std::vector<integer> _parsedCapacities;
+      std::vector<integer> _parsedSafetyCapacities;
+      integer const * _capacities;
+      integer const * _safetyCapacities;
+      boost::shared_ptr<MoveCostMatrix const> _moveCosts;
    };
 
    class Service
@@ -107,7 +247,8 @@ namespace inst
               int moveCost)
          : _id(id),
            _service(service),
-           _requirements(requirements),
+           _parsedRequirements(requirements),
+           _requirements(0),
            _moveCost(moveCost)
       {
       }
@@ -118,14 +259,26 @@ namespace inst
       integer requirement(int resource) const
       { return _requirements[resource]; }
 
-      std::vector<integer> const & requirements() const
+      // Padded to Instance::resourceStride() with zeros.
+      integer const * requirements() const
       { return  _requirements; }
 
+      std::vector<integer> const & parsedRequirements() const
+      { return _parsedRequirements; }
+
+      // Called by Instance once the requirements are copied in its
+      // process x resource array.
+      void bindRequirements(integer const * requirements)
+      {
+         _requirements = requirements;
+         std::vector<integer>().swap(_parsedRequirements);
+      }
 
    private:
       int _id;
       int _service;
-      std::vector<integer> _requirements;
+      std::vector<integer> _parsedRequirements;
+      integer const * _requirements;
       int _moveCost;
    };
 
@@ -188,11 +341,19 @@ namespace inst
       std::set<int> _machines;
    };
 
+   // Processes and machines keep pointers into the instance, so it
+   // can't be copied.
    class Instance
    {
    public:
+      // The machines of a solution snapshot are stored on 16 bits.
+      static const int maxNumMachines = 65536;
+
+      // Throws std::runtime_error if there are more than
+      // maxNumMachines machines.
       Instance(const std::vector<Resource>& resources,
                const std::vector<Machine>& machines,
+               boost::shared_ptr<MoveCostMatrix const> const & moveCosts,
                const std::vector<Service>& services,
                const std::vector<Process>& processes,
                const std::vector<BalanceCost>& balanceCosts,
@@ -204,6 +365,7 @@ namespace inst
                int numLocations)
          : _resources(resources),
            _machines(machines),
+           _moveCosts(moveCosts),
            _services(services),
            _processes(processes),
            _balanceCosts(balanceCosts),
@@ -214,14 +376,56 @@ namespace inst
            _numNeighborhoods(numNeighborhoods),
            _numLocations(numLocations),
            _numResources(_resources.size()),
-           _resourcesLoadCostWeight(_resources.size(), 0)
+           _resourceStride(paddedStride(_numResources)),
+           _resourcesLoadCostWeight(_resourceStride),
+           _transientMask(_resourceStride),
+           _requirements(_processes.size() * _resourceStride),
+           _capacities(_machines.size() * _resourceStride),
+           _safetyCapacities(_machines.size() * _resourceStride)
       {
+         if (_machines.size() > maxNumMachines)
+            throw std::runtime_error("too many machines (at most 65536)");
+
          for (int i = 0; i < numResources(); i++)
          {
             _isTransient.push_back(_resources[i].transient());
             _resourcesLoadCostWeight[i] = _resources[i].loadCostWeight();
+            _transientMask[i] = _resources[i].transient() ? ~integer(0) : 0;
+         }
+
+         // Pack the per-process and per-machine vectors in the flat
+         // arrays (the padding stays at zero).
+         for (int i = 0; i < _processes.size(); i++)
+         {
+            integer * requirements = &_requirements[i * _resourceStride];
+
+            std::copy(_processes[i].parsedRequirements().begin(),
+                      _processes[i].parsedRequirements().end(),
+                      requirements);
+
+            _processes[i].bindRequirements(requirements);
+         }
+
+         for (int i = 0; i < _machines.size(); i++)
+         {
+            integer * capacities = &_capacities[i * _resourceStride];
+            integer * safetyCapacities
+               = &_safetyCapacities[i * _resourceStride];
+
+            std::copy(_machines[i].parsedCapacities().begin(),
+                      _machines[i].parsedCapacities().end(),
+                      capacities);
+            std::copy(_machines[i].parsedSafetyCapacities().begin(),
+                      _machines[i].parsedSafetyCapacities().end(),
+                      safetyCapacities);
+
+            _machines[i].bindCapacities(capacities, safetyCapacities);
          }
 
+         _narrowValues = fitsInt32(_requirements)
+            && fitsInt32(_resourcesLoadCostWeight)
+            && fitsInt32(_capacities);
+
          for (int i = 0; i < _processes.size(); i++)
          {
             _services[_processes[i].service()].addProcess(i);
@@ -261,6 +465,11 @@ namespace inst
       int numNeighborhoods() const { return _numNeighborhoods; }
       int numProcesses() const { return _processes.size(); }
       int numResources() const { return _numResources; }
+
+      // Distance between two consecutive rows of the process x resource
+      // and machine x resource arrays: numResources() rounded up to a
+      // multiple of four 64-bit values (one AVX2 register).
+      int resourceStride() const { return _resourceStride; }
       int numServices() const { return _services.size(); }
 
       BalanceCost const & balanceCost(int balanceCost) const
@@ -277,6 +486,11 @@ namespace inst
       
       const Machine& machine(int machine) const { return _machines[machine]; }
 
+      integer moveCost(int srcMachine, int dstMachine) const
+      { return _moveCosts->moveCost(srcMachine, dstMachine); }
+
+      MoveCostMatrix const & moveCosts() const { return *_moveCosts; }
+
       Neighborhood const & neighborhood(int neighborhood) const
       { return _neighborhoods[neighborhood]; }
 
@@ -299,15 +513,30 @@ namespace inst
       std::vector<int> const & initAssignment() const
       { return _initAssignment; }
 
-      std::vector<integer> const & resourcesLoadCostWeight() const
+      // Padded to resourceStride() with zeros.
+      integer const * resourcesLoadCostWeight() const
+      {
+         return _resourcesLoadCostWeight.data();
+      }
+
+      // All bits set for the transient resources, padded to
+      // resourceStride() with zeros.
+      integer const * transientMask() const
       {
-         return _resourcesLoadCostWeight;
+         return _transientMask.data();
       }
+
+      // True if the requirements, the load cost weights and the
+      // capacities are in [0, 2^31), so that their products with
+      // weights and balance targets can be computed on 32-bit
+      // multipliers.
+      bool narrowValues() const { return _narrowValues; }
    
 
    private:
       std::vector<Resource> _resources;
       std::vector<Machine> _machines;
+      boost::shared_ptr<MoveCostMatrix const> _moveCosts;
       std::vector<Service> _services;
       std::vector<Process> _processes;
       std::vector<BalanceCost> _balanceCosts;
@@ -325,7 +554,32 @@ namespace inst
       int _numNeighborhoods;
       int _numLocations;
       int _numResources;
-      std::vector<integer> _resourcesLoadCostWeight;
+      int _resourceStride;
+      AlignedArray<integer> _resourcesLoadCostWeight;
+      AlignedArray<integer> _transientMask;
+      AlignedArray<integer> _requirements;     // process -> resource
+      AlignedArray<integer> _capacities;       // machine -> resource
+      AlignedArray<integer> _safetyCapacities; // machine -> resource
+      bool _narrowValues;
+
+      Instance(Instance const &);
+      Instance & operator=(Instance const &);
+
+      static bool fitsInt32(AlignedArray<integer> const & values)
+      {
+         for (std::size_t i = 0; i < values.size(); i++)
+         {
+            if (values[i] < 0 || values[i] > 0x7fffffff)
+               return false;
+         }
+
+         return true;
+      }
+
+      static int paddedStride(int numResources)
+      {
+         return (numResources + 3) / 4 * 4;
+      }
    };
 }
 #endif
@@ -0,0 +1,58 @@
+#ifndef ISLAND_HPP
+#define ISLAND_HPP
+
+#include "shared_pool.hpp"
+#include "solution.hpp"
+
+#include <vector>
+
+// The elite pool a worker adds its best solutions to and restarts
+// from, and the pools of its neighbors, to which the best solution of
+// the pool migrates every migrationInterval ILS iterations. Without
+// neighbors, the pool is typically shared by all the workers.
+class Island
+{
+public:
+   Island(SharedPool * pool, int migrationInterval)
+      : _pool(pool),
+        _migrationInterval(migrationInterval),
+        _numIter(0)
+   {
+   }
+
+   void addNeighbor(SharedPool * neighbor)
+   {
+      _neighbors.push_back(neighbor);
+   }
+
+   SharedPool * pool() const
+   {
+      return _pool;
+   }
+
+   // Called once per ILS iteration.
+   void iterationDone()
+   {
+      _numIter++;
+
+      if (_neighbors.empty() || _migrationInterval <= 0
+          || _numIter % _migrationInterval != 0)
+         return;
+
+      if (!_pool->getBestSolution(&_migrant))
+         return;
+
+      // The pools are locked one at a time.
+      for (int i = 0; i < _neighbors.size(); i++)
+         _neighbors[i]->addSolution(_migrant);
+   }
+
+private:
+   SharedPool * _pool;
+   std::vector<SharedPool *> _neighbors;
+   int _migrationInterval;
+   long long _numIter;
+   sol::Snapshot _migrant;
+};
+
+#endif
@@ -1,76 +1,135 @@
 #ifndef ITERATED_LS_HPP
 #define ITERATED_LS_HPP
 
+#include "allocation_counter.hpp"
 #include "instance.hpp"
 #include "pool.hpp"
+#include "island.hpp"
 #include "solution.hpp"
 
 #include <cmath>
+#include <iostream>
 #include <limits>
 
 template <typename LocalSearch, typename Perturbation>
 class IteratedLocalSearch
 {
 public:
+   // With an island, the best solutions are added to its pool, and a
+   // run also stops after maxNumBehindIter iterations without
+   // improvement if the pool has a better solution.
    IteratedLocalSearch(int maxNumNonImprovIter,
                        LocalSearch *  localSearch,
                        Perturbation * perturbation,
-                       Pool * pool)
+                       Pool * pool,
+                       Island * island = 0,
+                       int maxNumBehindIter = 0)
       : _maxNumNonImprovIter(maxNumNonImprovIter),
         _localSearch(localSearch),
         _perturbation(perturbation),
-        _pool(pool)
+        _pool(pool),
+        _island(island),
+        _maxNumBehindIter(maxNumBehindIter)
    {
    }
 
-   void apply(sol::Solution const & solution)
+   // Searches in place from "solution", which is left at the best
+   // solution found: the moves made since the best one are rolled back
+   // rather than the best solution being copied.
+   template <typename Solution>
+   void apply(Solution & solution)
    {
       int numIter = 0;
       int lastBestIter = -1;
 
-      sol::Solution bestSolution(solution);
-      sol::Solution currentSolution(_localSearch->apply(solution));
+      solution.commit();
+      sol::ObjValue bestObjValue(solution.objValue());
 
-      if (isBetter(currentSolution, bestSolution))
+      _localSearch->apply(solution);
+
+      if (isBetter(solution.objValue(), bestObjValue))
       {
          lastBestIter = 0;
-         bestSolution = currentSolution;
+         bestObjValue = solution.objValue();
+         solution.commit();
       }
       
+#ifdef J10_COUNT_ALLOCATIONS
+      int numAllocatingIter = 0;
+      unsigned long long numAllocations = 0;
+#endif
+
       do
       {
-         currentSolution = _perturbation->apply(currentSolution);
-         currentSolution = _localSearch->apply(currentSolution);
+#ifdef J10_COUNT_ALLOCATIONS
+         unsigned long long allocationsBefore = alloc::count();
+#endif
 
-         _pool->addSolution(currentSolution);
+         _perturbation->apply(solution);
+         _localSearch->apply(solution);
 
-         if (isBetter(currentSolution, bestSolution))
+         _pool->addSolution(solution);
+
+         if (isBetter(solution.objValue(), bestObjValue))
          {
             lastBestIter = numIter;
-            bestSolution = currentSolution;
+            bestObjValue = solution.objValue();
+            solution.commit();
+
+            if (_island != 0)
+               _island->pool()->addSolution(solution);
          }
 
+         if (_island != 0)
+            _island->iterationDone();
+
+#ifdef J10_COUNT_ALLOCATIONS
+         unsigned long long allocations = alloc::count() - allocationsBefore;
+         numAllocatingIter += (allocations != 0);
+         numAllocations += allocations;
+#endif
+
          numIter++;
          
          boost::this_thread::interruption_point();
       }
-      while ((numIter - lastBestIter) <= _maxNumNonImprovIter);
+      while ((numIter - lastBestIter) <= _maxNumNonImprovIter
+             && !isBehind(numIter - lastBestIter, bestObjValue));
+
+      solution.rollback(0);
+
+#ifdef J10_COUNT_ALLOCATIONS
+      std::cerr << "ils: " << numIter << " iterations, "
+                << numAllocatingIter << " allocating, "
+                << numAllocations << " allocations" << std::endl;
+#endif
    }
    
 private:
-   bool isBetter(sol::Solution const & sol1,
-                 sol::Solution const & sol2) const
+   bool isBetter(sol::ObjValue const & objValue1,
+                 sol::ObjValue const & objValue2) const
    {
-      inst::integer value1 = sol1.objValue().objValue();
-      inst::integer value2 = sol2.objValue().objValue();
+      inst::integer value1 = objValue1.objValue();
+      inst::integer value2 = objValue2.objValue();
       
       return value1 < value2;
    }
 
+   // The best value of the pool is read without a lock.
+   bool isBehind(int numNonImprovIter, sol::ObjValue const & bestObjValue)
+      const
+   {
+      return _island != 0
+         && numNonImprovIter > _maxNumBehindIter
+         && _island->pool()->bestValue() < bestObjValue.objValue();
+   }
+
    int _maxNumNonImprovIter;
    LocalSearch * _localSearch;
    Perturbation * _perturbation;
    Pool * _pool;
+   Island * _island;
+   int _maxNumBehindIter;
 };
 
 #endif
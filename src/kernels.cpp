@@ -0,0 +1,713 @@
+#include "kernels.hpp"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define J10_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using kernels::integer;
+
+namespace
+{
+   template <int Stride>
+   integer scalarLoadCostDelta(int dynamicStride,
+                               integer const * requirements,
+                               integer const * loadCostWeights,
+                               integer const * srcOverSafetyCapacity,
+                               integer const * dstUnderSafetyCapacity)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      integer deltaObjValue = 0;
+
+      for (int i = 0; i < stride; i++)
+      {
+         integer requirement = requirements[i];
+
+         // The source overflow is only reduced if the machine is over
+         // its safety capacity, and the destination only overflows by
+         // what doesn't fit under its safety capacity.
+         integer srcDelta = std::max(
+            static_cast<integer>(0),
+            std::min(srcOverSafetyCapacity[i], requirement));
+
+         integer dstDelta = std::max(
+            static_cast<integer>(0),
+            requirement - dstUnderSafetyCapacity[i]);
+
+         deltaObjValue += loadCostWeights[i] * (dstDelta - srcDelta);
+      }
+
+      return deltaObjValue;
+   }
+
+   template <int Stride>
+   bool scalarFitsCapacity(int dynamicStride,
+                           integer const * dstUsage,
+                           integer const * requirements,
+                           integer const * dstCapacities,
+                           integer const * transientMask,
+                           bool isInitialDstMachine)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      // On the initial machine, the transient requirements are already
+      // in the usage: they are masked out.
+      integer skipTransient = isInitialDstMachine ? ~integer(0) : 0;
+
+      for (int i = 0; i < stride; i++)
+      {
+         integer requirement
+            = requirements[i] & ~(transientMask[i] & skipTransient);
+
+         if (dstUsage[i] + requirement > dstCapacities[i])
+            return false;
+      }
+
+      return true;
+   }
+
+   template <int Stride>
+   bool scalarFitsLoadCostDelta(int dynamicStride,
+                                integer const * requirements,
+                                integer const * loadCostWeights,
+                                integer const * transientMask,
+                                bool isInitialDstMachine,
+                                integer const * srcOverSafetyCapacity,
+                                integer const * dstUsage,
+                                integer const * dstCapacities,
+                                integer const * dstUnderSafetyCapacity,
+                                integer * loadCostDelta)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      integer skipTransient = isInitialDstMachine ? ~integer(0) : 0;
+      integer deltaObjValue = 0;
+
+      for (int i = 0; i < stride; i++)
+      {
+         integer requirement = requirements[i];
+
+         if (dstUsage[i] + (requirement & ~(transientMask[i] & skipTransient))
+             > dstCapacities[i])
+            return false;
+
+         integer srcDelta = std::max(
+            static_cast<integer>(0),
+            std::min(srcOverSafetyCapacity[i], requirement));
+
+         integer dstDelta = std::max(
+            static_cast<integer>(0),
+            requirement - dstUnderSafetyCapacity[i]);
+
+         deltaObjValue += loadCostWeights[i] * (dstDelta - srcDelta);
+      }
+
+      *loadCostDelta = deltaObjValue;
+
+      return true;
+   }
+
+   // Balance value of a machine: max(0, target x remaining first
+   // resource - remaining second resource), where remaining is
+   // max(0, capacity - usage).
+   integer balanceValue(integer target,
+                        integer capacityFirst, integer usageFirst,
+                        integer capacitySecond, integer usageSecond)
+   {
+      integer remainingFirst
+         = std::max(static_cast<integer>(0), capacityFirst - usageFirst);
+      integer remainingSecond
+         = std::max(static_cast<integer>(0), capacitySecond - usageSecond);
+
+      return std::max(static_cast<integer>(0),
+                      target * remainingFirst - remainingSecond);
+   }
+
+   integer scalarBalanceDelta(kernels::BalanceCosts const & balanceCosts,
+                              integer const * requirements,
+                              integer const * srcUsage,
+                              integer const * srcCapacities,
+                              integer const * dstUsage,
+                              integer const * dstCapacities)
+   {
+      integer deltaObjValue = 0;
+
+      for (int i = 0; i < balanceCosts.size; i++)
+      {
+         int first = balanceCosts.firstResources[i];
+         int second = balanceCosts.secondResources[i];
+         integer target = balanceCosts.targets[i];
+
+         integer delta
+            = balanceValue(target,
+                           srcCapacities[first],
+                           srcUsage[first] - requirements[first],
+                           srcCapacities[second],
+                           srcUsage[second] - requirements[second])
+            - balanceValue(target,
+                           srcCapacities[first], srcUsage[first],
+                           srcCapacities[second], srcUsage[second])
+            + balanceValue(target,
+                           dstCapacities[first],
+                           dstUsage[first] + requirements[first],
+                           dstCapacities[second],
+                           dstUsage[second] + requirements[second])
+            - balanceValue(target,
+                           dstCapacities[first], dstUsage[first],
+                           dstCapacities[second], dstUsage[second]);
+
+         deltaObjValue += balanceCosts.weights[i] * delta;
+      }
+
+      return deltaObjValue;
+   }
+
+#ifdef J10_X86_KERNELS
+
+   template <int Stride>
+   __attribute__((target("sse4.2")))
+   integer sseLoadCostDelta(int dynamicStride,
+                            integer const * requirements,
+                            integer const * loadCostWeights,
+                            integer const * srcOverSafetyCapacity,
+                            integer const * dstUnderSafetyCapacity)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      __m128i const zero = _mm_setzero_si128();
+      __m128i sum = zero;
+
+      for (int i = 0; i < stride; i += 2)
+      {
+         __m128i requirement = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(requirements + i));
+         __m128i weight = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(loadCostWeights + i));
+         __m128i over = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(srcOverSafetyCapacity + i));
+         __m128i under = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(dstUnderSafetyCapacity + i));
+
+         __m128i srcDelta = _mm_blendv_epi8(
+            over, requirement, _mm_cmpgt_epi64(over, requirement));
+         srcDelta = _mm_and_si128(srcDelta, _mm_cmpgt_epi64(srcDelta, zero));
+
+         __m128i dstDelta = _mm_sub_epi64(requirement, under);
+         dstDelta = _mm_and_si128(dstDelta, _mm_cmpgt_epi64(dstDelta, zero));
+
+         // Both deltas are in [0, requirement], their difference fits
+         // in the low 32 bits.
+         sum = _mm_add_epi64(
+            sum, _mm_mul_epi32(_mm_sub_epi64(dstDelta, srcDelta), weight));
+      }
+
+      return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1);
+   }
+
+   template <int Stride>
+   __attribute__((target("sse4.2")))
+   bool sseFitsCapacity(int dynamicStride,
+                        integer const * dstUsage,
+                        integer const * requirements,
+                        integer const * dstCapacities,
+                        integer const * transientMask,
+                        bool isInitialDstMachine)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      __m128i skipTransient = _mm_set1_epi64x(isInitialDstMachine ? -1 : 0);
+      __m128i overflow = _mm_setzero_si128();
+
+      for (int i = 0; i < stride; i += 2)
+      {
+         __m128i requirement = _mm_andnot_si128(
+            _mm_and_si128(_mm_loadu_si128(
+                             reinterpret_cast<__m128i const *>(
+                                transientMask + i)),
+                          skipTransient),
+            _mm_loadu_si128(
+               reinterpret_cast<__m128i const *>(requirements + i)));
+         __m128i usage = _mm_add_epi64(
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(dstUsage + i)),
+            requirement);
+         __m128i capacity = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(dstCapacities + i));
+
+         overflow = _mm_or_si128(overflow, _mm_cmpgt_epi64(usage, capacity));
+      }
+
+      return _mm_testz_si128(overflow, overflow);
+   }
+
+   template <int Stride>
+   __attribute__((target("sse4.2")))
+   bool sseFitsLoadCostDelta(int dynamicStride,
+                             integer const * requirements,
+                             integer const * loadCostWeights,
+                             integer const * transientMask,
+                             bool isInitialDstMachine,
+                             integer const * srcOverSafetyCapacity,
+                             integer const * dstUsage,
+                             integer const * dstCapacities,
+                             integer const * dstUnderSafetyCapacity,
+                             integer * loadCostDelta)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      __m128i const zero = _mm_setzero_si128();
+      __m128i skipTransient = _mm_set1_epi64x(isInitialDstMachine ? -1 : 0);
+      __m128i sum = zero;
+
+      for (int i = 0; i < stride; i += 2)
+      {
+         __m128i requirement = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(requirements + i));
+
+         __m128i usage = _mm_add_epi64(
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(dstUsage + i)),
+            _mm_andnot_si128(
+               _mm_and_si128(_mm_loadu_si128(
+                                reinterpret_cast<__m128i const *>(
+                                   transientMask + i)),
+                             skipTransient),
+               requirement));
+         __m128i capacity = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(dstCapacities + i));
+
+         __m128i overflow = _mm_cmpgt_epi64(usage, capacity);
+
+         if (!_mm_testz_si128(overflow, overflow))
+            return false;
+
+         __m128i weight = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(loadCostWeights + i));
+         __m128i over = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(srcOverSafetyCapacity + i));
+         __m128i under = _mm_loadu_si128(
+            reinterpret_cast<__m128i const *>(dstUnderSafetyCapacity + i));
+
+         __m128i srcDelta = _mm_blendv_epi8(
+            over, requirement, _mm_cmpgt_epi64(over, requirement));
+         srcDelta = _mm_and_si128(srcDelta, _mm_cmpgt_epi64(srcDelta, zero));
+
+         __m128i dstDelta = _mm_sub_epi64(requirement, under);
+         dstDelta = _mm_and_si128(dstDelta, _mm_cmpgt_epi64(dstDelta, zero));
+
+         sum = _mm_add_epi64(
+            sum, _mm_mul_epi32(_mm_sub_epi64(dstDelta, srcDelta), weight));
+      }
+
+      *loadCostDelta = _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1);
+
+      return true;
+   }
+
+   // The two lanes are the machine before and after the move.
+   __attribute__((target("sse4.2")))
+   __m128i sseBalanceValues(__m128i target,
+                            integer capacityFirst,
+                            integer usageFirst,
+                            integer requirementFirst,
+                            integer capacitySecond,
+                            integer usageSecond,
+                            integer requirementSecond)
+   {
+      __m128i const zero = _mm_setzero_si128();
+
+      __m128i remainingFirst = _mm_sub_epi64(
+         _mm_set1_epi64x(capacityFirst - usageFirst),
+         _mm_set_epi64x(requirementFirst, 0));
+      remainingFirst = _mm_and_si128(remainingFirst,
+                                     _mm_cmpgt_epi64(remainingFirst, zero));
+
+      __m128i remainingSecond = _mm_sub_epi64(
+         _mm_set1_epi64x(capacitySecond - usageSecond),
+         _mm_set_epi64x(requirementSecond, 0));
+      remainingSecond = _mm_and_si128(remainingSecond,
+                                      _mm_cmpgt_epi64(remainingSecond, zero));
+
+      __m128i value = _mm_sub_epi64(_mm_mul_epi32(remainingFirst, target),
+                                    remainingSecond);
+
+      return _mm_and_si128(value, _mm_cmpgt_epi64(value, zero));
+   }
+
+   __attribute__((target("sse4.2")))
+   integer sseBalanceDelta(kernels::BalanceCosts const & balanceCosts,
+                           integer const * requirements,
+                           integer const * srcUsage,
+                           integer const * srcCapacities,
+                           integer const * dstUsage,
+                           integer const * dstCapacities)
+   {
+      integer deltaObjValue = 0;
+
+      for (int i = 0; i < balanceCosts.size; i++)
+      {
+         int first = balanceCosts.firstResources[i];
+         int second = balanceCosts.secondResources[i];
+         __m128i target = _mm_set1_epi64x(balanceCosts.targets[i]);
+
+         // Removing the process from the source is adding a negative
+         // requirement.
+         __m128i src = sseBalanceValues(
+            target, srcCapacities[first], srcUsage[first],
+            -requirements[first], srcCapacities[second], srcUsage[second],
+            -requirements[second]);
+
+         __m128i dst = sseBalanceValues(
+            target, dstCapacities[first], dstUsage[first],
+            requirements[first], dstCapacities[second], dstUsage[second],
+            requirements[second]);
+
+         // (after - before) on both machines.
+         __m128i values = _mm_add_epi64(src, dst);
+         integer delta
+            = _mm_extract_epi64(values, 1) - _mm_cvtsi128_si64(values);
+
+         deltaObjValue += balanceCosts.weights[i] * delta;
+      }
+
+      return deltaObjValue;
+   }
+
+   template <int Stride>
+   __attribute__((target("avx2")))
+   integer avx2LoadCostDelta(int dynamicStride,
+                             integer const * requirements,
+                             integer const * loadCostWeights,
+                             integer const * srcOverSafetyCapacity,
+                             integer const * dstUnderSafetyCapacity)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      __m256i const zero = _mm256_setzero_si256();
+      __m256i sum = zero;
+
+      for (int i = 0; i < stride; i += 4)
+      {
+         __m256i requirement = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(requirements + i));
+         __m256i weight = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(loadCostWeights + i));
+         __m256i over = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(srcOverSafetyCapacity + i));
+         __m256i under = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(dstUnderSafetyCapacity + i));
+
+         __m256i srcDelta = _mm256_blendv_epi8(
+            over, requirement, _mm256_cmpgt_epi64(over, requirement));
+         srcDelta = _mm256_and_si256(srcDelta,
+                                     _mm256_cmpgt_epi64(srcDelta, zero));
+
+         __m256i dstDelta = _mm256_sub_epi64(requirement, under);
+         dstDelta = _mm256_and_si256(dstDelta,
+                                     _mm256_cmpgt_epi64(dstDelta, zero));
+
+         sum = _mm256_add_epi64(
+            sum,
+            _mm256_mul_epi32(_mm256_sub_epi64(dstDelta, srcDelta), weight));
+      }
+
+      __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sum),
+                                   _mm256_extracti128_si256(sum, 1));
+
+      return _mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1);
+   }
+
+   template <int Stride>
+   __attribute__((target("avx2")))
+   bool avx2FitsCapacity(int dynamicStride,
+                         integer const * dstUsage,
+                         integer const * requirements,
+                         integer const * dstCapacities,
+                         integer const * transientMask,
+                         bool isInitialDstMachine)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      __m256i skipTransient
+         = _mm256_set1_epi64x(isInitialDstMachine ? -1 : 0);
+      __m256i overflow = _mm256_setzero_si256();
+
+      for (int i = 0; i < stride; i += 4)
+      {
+         __m256i requirement = _mm256_andnot_si256(
+            _mm256_and_si256(_mm256_loadu_si256(
+                                reinterpret_cast<__m256i const *>(
+                                   transientMask + i)),
+                             skipTransient),
+            _mm256_loadu_si256(
+               reinterpret_cast<__m256i const *>(requirements + i)));
+         __m256i usage = _mm256_add_epi64(
+            _mm256_loadu_si256(
+               reinterpret_cast<__m256i const *>(dstUsage + i)),
+            requirement);
+         __m256i capacity = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(dstCapacities + i));
+
+         overflow = _mm256_or_si256(overflow,
+                                    _mm256_cmpgt_epi64(usage, capacity));
+      }
+
+      return _mm256_testz_si256(overflow, overflow);
+   }
+
+   template <int Stride>
+   __attribute__((target("avx2")))
+   bool avx2FitsLoadCostDelta(int dynamicStride,
+                              integer const * requirements,
+                              integer const * loadCostWeights,
+                              integer const * transientMask,
+                              bool isInitialDstMachine,
+                              integer const * srcOverSafetyCapacity,
+                              integer const * dstUsage,
+                              integer const * dstCapacities,
+                              integer const * dstUnderSafetyCapacity,
+                              integer * loadCostDelta)
+   {
+      int const stride = Stride ? Stride : dynamicStride;
+      __m256i const zero = _mm256_setzero_si256();
+      __m256i skipTransient
+         = _mm256_set1_epi64x(isInitialDstMachine ? -1 : 0);
+      __m256i sum = zero;
+
+      for (int i = 0; i < stride; i += 4)
+      {
+         __m256i requirement = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(requirements + i));
+
+         __m256i usage = _mm256_add_epi64(
+            _mm256_loadu_si256(
+               reinterpret_cast<__m256i const *>(dstUsage + i)),
+            _mm256_andnot_si256(
+               _mm256_and_si256(_mm256_loadu_si256(
+                                   reinterpret_cast<__m256i const *>(
+                                      transientMask + i)),
+                                skipTransient),
+               requirement));
+         __m256i capacity = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(dstCapacities + i));
+
+         __m256i overflow = _mm256_cmpgt_epi64(usage, capacity);
+
+         if (!_mm256_testz_si256(overflow, overflow))
+            return false;
+
+         __m256i weight = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(loadCostWeights + i));
+         __m256i over = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(srcOverSafetyCapacity + i));
+         __m256i under = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(dstUnderSafetyCapacity + i));
+
+         __m256i srcDelta = _mm256_blendv_epi8(
+            over, requirement, _mm256_cmpgt_epi64(over, requirement));
+         srcDelta = _mm256_and_si256(srcDelta,
+                                     _mm256_cmpgt_epi64(srcDelta, zero));
+
+         __m256i dstDelta = _mm256_sub_epi64(requirement, under);
+         dstDelta = _mm256_and_si256(dstDelta,
+                                     _mm256_cmpgt_epi64(dstDelta, zero));
+
+         sum = _mm256_add_epi64(
+            sum,
+            _mm256_mul_epi32(_mm256_sub_epi64(dstDelta, srcDelta), weight));
+      }
+
+      __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sum),
+                                   _mm256_extracti128_si256(sum, 1));
+
+      *loadCostDelta = _mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1);
+
+      return true;
+   }
+
+   // The lanes are the source before and after the move, then the
+   // destination before and after the move.
+   __attribute__((target("avx2")))
+   integer avx2BalanceDelta(kernels::BalanceCosts const & balanceCosts,
+                            integer const * requirements,
+                            integer const * srcUsage,
+                            integer const * srcCapacities,
+                            integer const * dstUsage,
+                            integer const * dstCapacities)
+   {
+      __m256i const zero = _mm256_setzero_si256();
+      integer deltaObjValue = 0;
+
+      for (int i = 0; i < balanceCosts.size; i++)
+      {
+         int first = balanceCosts.firstResources[i];
+         int second = balanceCosts.secondResources[i];
+
+         __m256i remainingFirst = _mm256_sub_epi64(
+            _mm256_set_epi64x(dstCapacities[first] - dstUsage[first],
+                              dstCapacities[first] - dstUsage[first],
+                              srcCapacities[first] - srcUsage[first],
+                              srcCapacities[first] - srcUsage[first]),
+            _mm256_set_epi64x(requirements[first], 0,
+                              -requirements[first], 0));
+         remainingFirst = _mm256_and_si256(
+            remainingFirst, _mm256_cmpgt_epi64(remainingFirst, zero));
+
+         __m256i remainingSecond = _mm256_sub_epi64(
+            _mm256_set_epi64x(dstCapacities[second] - dstUsage[second],
+                              dstCapacities[second] - dstUsage[second],
+                              srcCapacities[second] - srcUsage[second],
+                              srcCapacities[second] - srcUsage[second]),
+            _mm256_set_epi64x(requirements[second], 0,
+                              -requirements[second], 0));
+         remainingSecond = _mm256_and_si256(
+            remainingSecond, _mm256_cmpgt_epi64(remainingSecond, zero));
+
+         __m256i value = _mm256_sub_epi64(
+            _mm256_mul_epi32(remainingFirst,
+                             _mm256_set1_epi64x(balanceCosts.targets[i])),
+            remainingSecond);
+         value = _mm256_and_si256(value, _mm256_cmpgt_epi64(value, zero));
+
+         // (after - before) on both machines.
+         __m128i values = _mm_add_epi64(_mm256_castsi256_si128(value),
+                                        _mm256_extracti128_si256(value, 1));
+         integer delta
+            = _mm_extract_epi64(values, 1) - _mm_cvtsi128_si64(values);
+
+         deltaObjValue += balanceCosts.weights[i] * delta;
+      }
+
+      return deltaObjValue;
+   }
+
+#endif
+
+   // Index 0 reads the stride at run time, the others are specialized
+   // for a stride of 4, 8 and 12.
+   int const numStrides = 4;
+
+   int strideIndex(int stride)
+   {
+      switch (stride)
+      {
+      case 4: return 1;
+      case 8: return 2;
+      case 12: return 3;
+      default: return 0;
+      }
+   }
+
+   kernels::Kernels const scalarKernels[numStrides] = {
+      { "scalar", scalarLoadCostDelta<0>, scalarFitsCapacity<0>,
+        scalarFitsLoadCostDelta<0>, scalarBalanceDelta },
+      { "scalar", scalarLoadCostDelta<4>, scalarFitsCapacity<4>,
+        scalarFitsLoadCostDelta<4>, scalarBalanceDelta },
+      { "scalar", scalarLoadCostDelta<8>, scalarFitsCapacity<8>,
+        scalarFitsLoadCostDelta<8>, scalarBalanceDelta },
+      { "scalar", scalarLoadCostDelta<12>, scalarFitsCapacity<12>,
+        scalarFitsLoadCostDelta<12>, scalarBalanceDelta }
+   };
+
+#ifdef J10_X86_KERNELS
+
+   kernels::Kernels const sseKernels[numStrides] = {
+      { "sse4.2", sseLoadCostDelta<0>, sseFitsCapacity<0>,
+        sseFitsLoadCostDelta<0>, sseBalanceDelta },
+      { "sse4.2", sseLoadCostDelta<4>, sseFitsCapacity<4>,
+        sseFitsLoadCostDelta<4>, sseBalanceDelta },
+      { "sse4.2", sseLoadCostDelta<8>, sseFitsCapacity<8>,
+        sseFitsLoadCostDelta<8>, sseBalanceDelta },
+      { "sse4.2", sseLoadCostDelta<12>, sseFitsCapacity<12>,
+        sseFitsLoadCostDelta<12>, sseBalanceDelta }
+   };
+
+   kernels::Kernels const avx2Kernels[numStrides] = {
+      { "avx2", avx2LoadCostDelta<0>, avx2FitsCapacity<0>,
+        avx2FitsLoadCostDelta<0>, avx2BalanceDelta },
+      { "avx2", avx2LoadCostDelta<4>, avx2FitsCapacity<4>,
+        avx2FitsLoadCostDelta<4>, avx2BalanceDelta },
+      { "avx2", avx2LoadCostDelta<8>, avx2FitsCapacity<8>,
+        avx2FitsLoadCostDelta<8>, avx2BalanceDelta },
+      { "avx2", avx2LoadCostDelta<12>, avx2FitsCapacity<12>,
+        avx2FitsLoadCostDelta<12>, avx2BalanceDelta }
+   };
+
+#else
+
+   // Not an x86-64 compiler: the vector kernels are the scalar ones
+   // (and are reported as unsupported).
+   kernels::Kernels const sseKernels[numStrides] = {
+      { "sse4.2", scalarLoadCostDelta<0>, scalarFitsCapacity<0>,
+        scalarFitsLoadCostDelta<0>, scalarBalanceDelta },
+      { "sse4.2", scalarLoadCostDelta<4>, scalarFitsCapacity<4>,
+        scalarFitsLoadCostDelta<4>, scalarBalanceDelta },
+      { "sse4.2", scalarLoadCostDelta<8>, scalarFitsCapacity<8>,
+        scalarFitsLoadCostDelta<8>, scalarBalanceDelta },
+      { "sse4.2", scalarLoadCostDelta<12>, scalarFitsCapacity<12>,
+        scalarFitsLoadCostDelta<12>, scalarBalanceDelta }
+   };
+
+   kernels::Kernels const avx2Kernels[numStrides] = {
+      { "avx2", scalarLoadCostDelta<0>, scalarFitsCapacity<0>,
+        scalarFitsLoadCostDelta<0>, scalarBalanceDelta },
+      { "avx2", scalarLoadCostDelta<4>, scalarFitsCapacity<4>,
+        scalarFitsLoadCostDelta<4>, scalarBalanceDelta },
+      { "avx2", scalarLoadCostDelta<8>, scalarFitsCapacity<8>,
+        scalarFitsLoadCostDelta<8>, scalarBalanceDelta },
+      { "avx2", scalarLoadCostDelta<12>, scalarFitsCapacity<12>,
+        scalarFitsLoadCostDelta<12>, scalarBalanceDelta }
+   };
+
+#endif
+
+   kernels::Kernels const * table(kernels::Kernels const & kernels)
+   {
+      if (&kernels >= sseKernels && &kernels < sseKernels + numStrides)
+         return sseKernels;
+
+      if (&kernels >= avx2Kernels && &kernels < avx2Kernels + numStrides)
+         return avx2Kernels;
+
+      return scalarKernels;
+   }
+}
+
+kernels::Kernels const & kernels::scalar = scalarKernels[0];
+kernels::Kernels const & kernels::sse = sseKernels[0];
+kernels::Kernels const & kernels::avx2 = avx2Kernels[0];
+
+bool kernels::isSupported(Kernels const & kernels)
+{
+   Kernels const * kernelsTable = table(kernels);
+
+   if (kernelsTable == scalarKernels)
+      return true;
+
+#ifdef J10_X86_KERNELS
+   __builtin_cpu_init();
+
+   if (kernelsTable == sseKernels)
+      return __builtin_cpu_supports("sse4.2");
+
+   if (kernelsTable == avx2Kernels)
+      return __builtin_cpu_supports("avx2");
+#endif
+
+   return false;
+}
+
+kernels::Kernels const & kernels::specialize(Kernels const & kernels,
+                                             int stride)
+{
+   return table(kernels)[strideIndex(stride)];
+}
+
+kernels::Kernels const & kernels::select(inst::Instance const & instance)
+{
+   int stride = instance.resourceStride();
+
+   if (!instance.narrowValues())
+      return specialize(scalar, stride);
+
+   if (isSupported(avx2))
+      return specialize(avx2, stride);
+
+   if (isSupported(sse))
+      return specialize(sse, stride);
+
+   return specialize(scalar, stride);
+}
@@ -0,0 +1,97 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include "instance.hpp"
+
+// Per-resource loops of the move evaluation, in a scalar, an SSE4.2
+// and an AVX2 version. The arrays are rows of resourceStride() values
+// padded with zeros, so the vector versions never need a remainder
+// loop.
+namespace kernels
+{
+   typedef inst::integer integer;
+
+   // Load cost delta of moving a process, given the over safety
+   // capacity of its source machine and the under safety capacity of
+   // its destination machine. The vector versions multiply on 32 bits:
+   // they require Instance::narrowValues().
+   typedef integer (*LoadCostDelta)(int stride,
+                                    integer const * requirements,
+                                    integer const * loadCostWeights,
+                                    integer const * srcOverSafetyCapacity,
+                                    integer const * dstUnderSafetyCapacity);
+
+   // True if the process fits in the destination machine (usage with
+   // transient). When the destination is the initial machine of the
+   // process, its transient resources are already counted there.
+   typedef bool (*FitsCapacity)(int stride,
+                                integer const * dstUsage,
+                                integer const * requirements,
+                                integer const * dstCapacities,
+                                integer const * transientMask,
+                                bool isInitialDstMachine);
+
+   // fitsCapacity and loadCostDelta in a single pass over the
+   // resources. Returns false if the process doesn't fit in the
+   // destination machine, otherwise sets *loadCostDelta. The vector
+   // versions require Instance::narrowValues().
+   typedef bool (*FitsLoadCostDelta)(int stride,
+                                     integer const * requirements,
+                                     integer const * loadCostWeights,
+                                     integer const * transientMask,
+                                     bool isInitialDstMachine,
+                                     integer const * srcOverSafetyCapacity,
+                                     integer const * dstUsage,
+                                     integer const * dstCapacities,
+                                     integer const * dstUnderSafetyCapacity,
+                                     integer * loadCostDelta);
+
+   // The balance costs of an instance as parallel arrays.
+   struct BalanceCosts
+   {
+      int size;
+      int const * firstResources;
+      int const * secondResources;
+      integer const * targets;
+      integer const * weights;
+   };
+
+   // Balance cost delta of moving a process. Only the first and second
+   // resources of each balance cost are read, on the source and the
+   // destination machines, before and after the move. The vector
+   // versions require Instance::narrowValues().
+   typedef integer (*BalanceDelta)(BalanceCosts const & balanceCosts,
+                                   integer const * requirements,
+                                   integer const * srcUsage,
+                                   integer const * srcCapacities,
+                                   integer const * dstUsage,
+                                   integer const * dstCapacities);
+
+   struct Kernels
+   {
+      char const * name;
+      LoadCostDelta loadCostDelta;
+      FitsCapacity fitsCapacity;
+      FitsLoadCostDelta fitsLoadCostDelta;
+      BalanceDelta balanceDelta;
+   };
+
+   // These kernels read the stride at run time.
+   extern Kernels const & scalar;
+   extern Kernels const & sse;
+   extern Kernels const & avx2;
+
+   // True if the processor can run these kernels.
+   bool isSupported(Kernels const & kernels);
+
+   // The same kernels with the stride built in, so that their loops
+   // are unrolled (strides 4, 8 and 12; any other stride keeps the
+   // run time one).
+   Kernels const & specialize(Kernels const & kernels, int stride);
+
+   // The fastest kernels supported by the processor which can handle
+   // the values of the instance, specialized for its stride.
+   Kernels const & select(inst::Instance const & instance);
+}
+
+#endif
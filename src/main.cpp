@@ -1,17 +1,34 @@
+#include "binary_instance.hpp"
+#include "instance.hpp"
+#include "parser.hpp"
 #include "pool.hpp"
+#include "island.hpp"
+#include "shared_pool.hpp"
 #include "solution.hpp"
 #include "worker.hpp"
 
 #include <boost/program_options.hpp>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 boost::program_options::variables_map parse(int argc, char* argv[]);
 
+inst::Instance* createInstance(
+   boost::program_options::variables_map const & param);
+
+std::vector<boost::shared_ptr<Island> > createIslands(
+   boost::program_options::variables_map const & param,
+   inst::Instance const & instance,
+   std::vector<boost::shared_ptr<SharedPool> > * pools);
+
 void printDetailedObjValue(sol::ObjValue const & objValue);
 
 int main(int argc, char* argv[])
@@ -34,6 +51,31 @@ int main(int argc, char* argv[])
       }
    }
 
+   if (param.count("compile-instance") > 0)
+   {
+      if (param.count("p") == 0 || param.count("i") == 0)
+      {
+         std::cerr << "Error: -p and -i are required to compile an instance."
+                   << std::endl;
+         return 1;
+      }
+
+      try
+      {
+         boost::shared_ptr<inst::Instance const>
+            instance(createInstance(param));
+         BinaryInstance::write(*instance,
+                               param["compile-instance"].as<std::string>());
+      }
+      catch (std::runtime_error const & e)
+      {
+         std::cerr << "Error: " << e.what() << std::endl;
+         return 1;
+      }
+
+      return 0;
+   }
+
    if (param.count("t") == 0 || param.count("p") == 0 || param.count("i") == 0
        || param.count("o") == 0 || param.count("s") == 0)
    {
@@ -41,12 +83,37 @@ int main(int argc, char* argv[])
    }
 
 
+   // Parsed once and shared (read-only) by all the workers.
+   boost::shared_ptr<inst::Instance const> instance;
+
+   try
+   {
+      instance.reset(createInstance(param));
+   }
+   catch (std::runtime_error const & e)
+   {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+   }
+
    std::vector<Worker*> workers;
    std::vector<boost::thread*> threads;
 
    int numThreads = param["d"].as<int>();
    int maxNumSolutions = param["b"].as<int>();
 
+   std::string const & topology = param["m"].as<std::string>();
+
+   if (topology != "ring" && topology != "all")
+   {
+      std::cerr << "Error: Unknown topology " << topology << "." << std::endl;
+      return 1;
+   }
+
+   std::vector<boost::shared_ptr<SharedPool> > pools;
+   std::vector<boost::shared_ptr<Island> > islands
+      = createIslands(param, *instance, &pools);
+
    boost::mt19937 gen(param["s"].as<unsigned int>());
    boost::uniform_int<unsigned int> 
       dist(0, std::numeric_limits<unsigned int>::max());
@@ -54,7 +121,9 @@ int main(int argc, char* argv[])
 
    for (int i = 0; i < numThreads; i++)
    {
-      workers.push_back(new Worker(param, dist(gen)));
+      workers.push_back(new Worker(param, instance,
+                                   islands.empty() ? 0 : islands[i].get(),
+                                   dist(gen)));
       threads.push_back(new boost::thread(boost::ref(*(workers.back()))));
    }
 
@@ -71,20 +140,45 @@ int main(int argc, char* argv[])
       threads[i]->join();
    }
 
-   sol::Solution bestSolution = workers.front()->bestSolution();
+   if (param.count("stats") > 0)
+   {
+      for (int i = 0; i < numThreads; i++)
+      {
+         Worker::Stats const & stats = workers[i]->stats();
+
+         std::cerr << "worker " << i << " (" << stats.solution << "): "
+                   << stats.numEvaluatedMoves << " moves evaluated in "
+                   << stats.seconds << " s, "
+                   << static_cast<long long>(
+                      stats.numEvaluatedMoves / std::max(stats.seconds, 1e-9))
+                   << " moves/s, " << stats.numBoundedMoves
+                   << " bounded";
+
+         if (param.count("concurrent-moves") > 0
+             || param["n"].as<int>() > 0)
+         {
+            std::cerr << ", " << stats.numStaleMoves << " stale, "
+                      << stats.numConflicts << " conflicts";
+         }
+
+         std::cerr << std::endl;
+      }
+   }
+
+   sol::Snapshot const * bestSolution = &workers.front()->bestSolution();
 
    for (int i = 1; i < numThreads; i++)
    {
-      sol::Solution sol = workers[i]->bestSolution();
+      sol::Snapshot const & sol = workers[i]->bestSolution();
 
-      if (sol.objValue() < bestSolution.objValue())
+      if (sol.objValue() < bestSolution->objValue())
       {
-         bestSolution = sol;
+         bestSolution = &sol;
       }
    }
 
 
-   std::vector<int> const & bestAssignment = bestSolution.assignment();
+   std::vector<int> bestAssignment = bestSolution->assignment();
    std::ofstream fileSolution(param["o"].as<std::string>().c_str());
 
    for (int i = 0; i < bestAssignment.size(); i++)
@@ -95,14 +189,80 @@ int main(int argc, char* argv[])
    fileSolution.close();
 
    // std::cerr << "Incremental" << std::endl;
-   // printDetailedObjValue(bestSolution.objValue());
+   // printDetailedObjValue(bestSolution->objValue());
 
    // std::cerr << std::endl << "Full" << std::endl;
-   // printDetailedObjValue(bestSolution.computeObjValue());
+   // printDetailedObjValue(sol::Solution(instance.get(), bestAssignment,
+   //                                     bestSolution->objValue())
+   //                       .computeObjValue());
 
    return 0;
 }
 
+inst::Instance* createInstance(
+   boost::program_options::variables_map const & param)
+{
+   std::string const & instanceFilename = param["p"].as<std::string>();
+
+   // A precompiled instance already contains the initial assignment.
+   if (BinaryInstance::isBinary(instanceFilename))
+      return BinaryInstance::load(instanceFilename);
+
+   return Parser::parse(instanceFilename, param["i"].as<std::string>());
+}
+
+std::vector<boost::shared_ptr<Island> > createIslands(
+   boost::program_options::variables_map const & param,
+   inst::Instance const & instance,
+   std::vector<boost::shared_ptr<SharedPool> > * pools)
+{
+   std::vector<boost::shared_ptr<Island> > islands;
+
+   int numThreads = param["d"].as<int>();
+   int maxNumSolutions = param["j"].as<int>();
+   int migrationInterval = param["l"].as<int>();
+
+   if (maxNumSolutions <= 0)
+      return islands;
+
+   // Elite solutions differ by at least a perturbation.
+   int minDistance = instance.numProcesses() * param["a"].as<double>();
+   int numPools = migrationInterval > 0 ? numThreads : 1;
+
+   for (int i = 0; i < numPools; i++)
+   {
+      pools->push_back(boost::shared_ptr<SharedPool>(
+                          new SharedPool(maxNumSolutions, minDistance)));
+   }
+
+   for (int i = 0; i < numThreads; i++)
+   {
+      islands.push_back(boost::shared_ptr<Island>(
+                           new Island((*pools)[i % numPools].get(),
+                                      migrationInterval)));
+   }
+
+   if (numPools == 1)
+      return islands;
+
+   for (int i = 0; i < numThreads; i++)
+   {
+      if (param["m"].as<std::string>() == "ring")
+      {
+         islands[i]->addNeighbor((*pools)[(i + 1) % numThreads].get());
+         continue;
+      }
+
+      for (int j = 0; j < numThreads; j++)
+      {
+         if (j != i)
+            islands[i]->addNeighbor((*pools)[j].get());
+      }
+   }
+
+   return islands;
+}
+
 void printDetailedObjValue(sol::ObjValue const & objValue)
 {
    std::cerr << "load = " << objValue.load() << std::endl
@@ -138,7 +298,28 @@ boost::program_options::variables_map parse(int argc, char* argv[])
       ("e", boost::program_options::value<int>()->default_value(500), 
        "local search num machines")
       ("f", boost::program_options::value<int>()->default_value(10), 
-       "local search number of retries");
+       "local search number of retries")
+      ("g", boost::program_options::value<int>()->default_value(64),
+       "relocation cost cache size in megabytes (per worker thread)")
+      ("h", boost::program_options::value<int>()->default_value(1),
+       "local search num threads (per worker thread)")
+      ("j", boost::program_options::value<int>()->default_value(0),
+       "num elite solutions shared by the threads (0: none)")
+      ("k", boost::program_options::value<int>()->default_value(20),
+       "max num iter without improvement behind the best of the pool")
+      ("l", boost::program_options::value<int>()->default_value(0),
+       "num iter between two migrations (0: one pool for all the threads)")
+      ("m", boost::program_options::value<std::string>()
+       ->default_value("ring"), "migration topology (ring, all)")
+      ("n", boost::program_options::value<int>()->default_value(0),
+       "num machine clusters searched in parallel (0: none)")
+      ("compile-instance", boost::program_options::value<std::string>(),
+       "write the instance (-p, -i) in the precompiled format and exit")
+      ("concurrent-moves", "with -h, the local search threads make their "
+       "own moves on the solution")
+      ("generic", "don't specialize the solver for the instance")
+      ("stats", "print the number of moves evaluated per second and "
+       "how many were bounded");
 
    boost::program_options::variables_map param;
 
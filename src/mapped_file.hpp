@@ -0,0 +1,80 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only view of a whole file mapped in memory.
+class MappedFile
+{
+public:
+
+   class Error : public std::runtime_error
+   {
+   public:
+      Error(std::string const & what)
+         : std::runtime_error(what)
+      {
+      }
+   };
+
+   MappedFile(std::string const & filename)
+      : _data(0),
+        _size(0)
+   {
+      int fd = open(filename.c_str(), O_RDONLY);
+
+      if (fd < 0)
+         throw Error("cannot open " + filename);
+
+      struct stat st;
+
+      if (fstat(fd, &st) != 0)
+      {
+         close(fd);
+         throw Error("cannot stat " + filename);
+      }
+
+      // An empty file can't be mapped, it is simply left empty.
+      if (st.st_size > 0)
+      {
+         // The files are always read entirely: populate the mapping
+         // at once rather than page fault by page fault.
+         void * data = mmap(0, st.st_size, PROT_READ,
+                            MAP_PRIVATE | MAP_POPULATE, fd, 0);
+
+         if (data == MAP_FAILED)
+         {
+            close(fd);
+            throw Error("cannot map " + filename);
+         }
+
+         _data = static_cast<char const *>(data);
+         _size = st.st_size;
+      }
+
+      close(fd);
+   }
+
+   ~MappedFile()
+   {
+      if (_data)
+         munmap(const_cast<char *>(_data), _size);
+   }
+
+   char const * data() const { return _data; }
+   unsigned long long size() const { return _size; }
+
+private:
+   MappedFile(MappedFile const &);
+   MappedFile & operator=(MappedFile const &);
+
+   char const * _data;
+   unsigned long long _size;
+};
+
+#endif
@@ -1,14 +1,17 @@
 #include "parser.hpp"
 
 #include <algorithm>
-#include <iostream>
 #include <map>
 
-inst::Instance* Parser::parse(std::ifstream & file,
-                              std::ifstream & fileAssignment)
+inst::Instance* Parser::parse(std::string const & modelFilename,
+                              std::string const & assignmentFilename)
 {
+   Tokenizer file(modelFilename);
+   Tokenizer fileAssignment(assignmentFilename);
+
    std::vector<inst::Resource> resources;
    std::vector<inst::Machine> machines;
+   boost::shared_ptr<inst::MoveCostMatrix> moveCosts;
    std::vector<inst::Service> services;
    std::vector<inst::Process> processes;
    std::vector<inst::BalanceCost> balanceCosts;
@@ -21,8 +24,8 @@ inst::Instance* Parser::parse(std::ifstream & file,
    int numLocations;
    
    parseRessources(file, resources);
-   parseMachines(file, resources.size(), machines, &numNeighborhoods,
-                 &numLocations);
+   parseMachines(file, resources.size(), machines, &moveCosts,
+                 &numNeighborhoods, &numLocations);
    parseServices(file, services);
    parseProcesses(file, resources.size(), processes);
    parseBalanceCosts(file, balanceCosts);
@@ -33,6 +36,7 @@ inst::Instance* Parser::parse(std::ifstream & file,
    inst::Instance* instance = new inst::Instance(
       resources,
       machines,
+      moveCosts,
       services,
       processes,
       balanceCosts,
@@ -46,47 +50,48 @@ inst::Instance* Parser::parse(std::ifstream & file,
    return instance;
 }
 
-void Parser::parseRessources(std::ifstream& file,
+void Parser::parseRessources(Tokenizer& file,
                              std::vector<inst::Resource>& resources)
 {
-   int numRessources;
-
-   file >> numRessources;
+   int numRessources = file.nextInteger();
 
    for (int i = 0; i < numRessources; i++)
    {
       bool transient;
       int loadCostWeight;
 
-      file >> transient;
-      file >> loadCostWeight;
+      transient = file.nextInteger();
+      loadCostWeight = file.nextInteger();
 
       resources.push_back(inst::Resource(i, transient, loadCostWeight));
    }
 }
 
-void Parser::parseMachines(std::ifstream& file, int numResources,
+void Parser::parseMachines(Tokenizer& file, int numResources,
                            std::vector<inst::Machine>& machines,
+                           boost::shared_ptr<inst::MoveCostMatrix> * moveCosts,
                            int * numNeighborhoods,
                            int * numLocations)
 {
-   int numMachines;
-
-   file >> numMachines;
+   int numMachines = file.nextInteger();
 
    std::map<int, int> neighborhoods;
    std::map<int, int> locations;
 
+   moveCosts->reset(new inst::MoveCostMatrix(numMachines));
+
    for (int i = 0; i < numMachines; i++)
    {
       int neighborhood;
       int location;
       std::vector<inst::integer> capacities;
       std::vector<inst::integer> safetyCapacities;
-      std::vector<inst::integer> moveCosts;
 
-      file >> neighborhood;
-      file >> location;
+      capacities.reserve(numResources);
+      safetyCapacities.reserve(numResources);
+
+      neighborhood = file.nextInteger();
+      location = file.nextInteger();
 
       //////////////////////////////////////////////////////////////////////
       // Ensure that neighborhoods and locations are indexed sequentially.
@@ -125,11 +130,15 @@ void Parser::parseMachines(std::ifstream& file, int numResources,
  
       fillArray(file, numResources, std::back_inserter(capacities));
       fillArray(file, numResources, std::back_inserter(safetyCapacities));
-      fillArray(file, numMachines,  std::back_inserter(moveCosts));
+
+      for (int j = 0; j < numMachines; j++)
+      {
+         (*moveCosts)->setMoveCost(i, j, file.nextInteger());
+      }
 
       machines.push_back(inst::Machine(i, neighborhood, location,
                                            capacities, safetyCapacities,
-                                           moveCosts));
+                                           *moveCosts));
    }
 
    *numNeighborhoods = neighborhoods.size();
@@ -137,12 +146,10 @@ void Parser::parseMachines(std::ifstream& file, int numResources,
 }
 
 
-void Parser::parseServices(std::ifstream& file,
+void Parser::parseServices(Tokenizer& file,
                            std::vector<inst::Service>& services)
 {
-   int numServices;
-
-   file >> numServices;
+   int numServices = file.nextInteger();
 
    std::vector<std::vector<int> > reverseDependencies(numServices);
 
@@ -152,8 +159,8 @@ void Parser::parseServices(std::ifstream& file,
       int numDependencies;
       std::vector<int> dependencies;
       
-      file >> spreadMin;
-      file >> numDependencies;
+      spreadMin = file.nextInteger();
+      numDependencies = file.nextInteger();
 
       fillArray(file, numDependencies, std::back_inserter(dependencies));
 
@@ -171,22 +178,20 @@ void Parser::parseServices(std::ifstream& file,
    }
 }
 
-void Parser::parseSolution(std::ifstream& file,
+void Parser::parseSolution(Tokenizer& file,
                            std::vector<int> * assignment)
 {
-   int machine;
-   while (file >> machine)
+   inst::integer machine;
+   while (file.next(machine))
    {
       assignment->push_back(machine);
    }
 }
 
-void Parser::parseProcesses(std::ifstream& file, int numResources,
+void Parser::parseProcesses(Tokenizer& file, int numResources,
                             std::vector<inst::Process>& processes)
 {
-   int numProcesses;
-
-   file >> numProcesses;
+   int numProcesses = file.nextInteger();
 
    for (int i = 0; i < numProcesses; i++)
    {
@@ -194,23 +199,21 @@ void Parser::parseProcesses(std::ifstream& file, int numResources,
       std::vector<inst::integer> requirements;
       int moveCost;
 
-      file >> service;
+      service = file.nextInteger();
 
       fillArray(file, numResources, std::back_inserter(requirements));
 
-      file >> moveCost;
+      moveCost = file.nextInteger();
 
       processes.push_back(inst::Process(i, service, requirements, moveCost));
 
    }
 }
 
-void Parser::parseBalanceCosts(std::ifstream& file,
+void Parser::parseBalanceCosts(Tokenizer& file,
                                std::vector<inst::BalanceCost>& balanceCosts)
 {
-   int numBalanceCosts;
-
-   file >> numBalanceCosts;
+   int numBalanceCosts = file.nextInteger();
 
    for (int i = 0; i < numBalanceCosts; i++)
    {
@@ -219,10 +222,10 @@ void Parser::parseBalanceCosts(std::ifstream& file,
       int target;
       int weight;
 
-      file >> firstResource;
-      file >> secondResource;
-      file >> target;
-      file >> weight;
+      firstResource = file.nextInteger();
+      secondResource = file.nextInteger();
+      target = file.nextInteger();
+      weight = file.nextInteger();
 
       balanceCosts.push_back(inst::BalanceCost(i, firstResource,
                                                    secondResource,
@@ -230,13 +233,13 @@ void Parser::parseBalanceCosts(std::ifstream& file,
    }
 }
 
-void Parser::parseWeights(std::ifstream& file, int& processMoveCostWeight,
+void Parser::parseWeights(Tokenizer& file, int& processMoveCostWeight,
                           int& serviceMoveCostWeight,
                           int& machineMoveCostWeight)
 {
-   file >> processMoveCostWeight;
-   file >> serviceMoveCostWeight;
-   file >> machineMoveCostWeight;
+   processMoveCostWeight = file.nextInteger();
+   serviceMoveCostWeight = file.nextInteger();
+   machineMoveCostWeight = file.nextInteger();
 }
 
 
@@ -2,51 +2,51 @@
 #define PARSER_HPP
 
 #include "instance.hpp"
-#include "solution.hpp"
+#include "tokenizer.hpp"
 
-#include <fstream>
+#include <boost/shared_ptr.hpp>
 #include <iterator>
+#include <string>
 
 class Parser
 {
 public:
-   static inst::Instance* parse(std::ifstream& file,
-                                std::ifstream & fileAssignment);
+   // Throws MappedFile::Error if one of the files can't be read.
+   static inst::Instance* parse(std::string const & modelFilename,
+                                std::string const & assignmentFilename);
 private:
    template <class OutputIterator>
-   static void fillArray(std::ifstream& file, int size, OutputIterator result);
+   static void fillArray(Tokenizer& file, int size, OutputIterator result);
 
 
-   static void parseRessources(std::ifstream& file,
+   static void parseRessources(Tokenizer& file,
                                std::vector<inst::Resource>& resources);
-   static void parseMachines(std::ifstream& file, int numResources,
+   static void parseMachines(Tokenizer& file, int numResources,
                              std::vector<inst::Machine>& machines,
+                             boost::shared_ptr<inst::MoveCostMatrix> *
+                             moveCosts,
                              int* numNeighborhoods,
                              int* numLocations);
-   static void parseServices(std::ifstream& file,
+   static void parseServices(Tokenizer& file,
                              std::vector<inst::Service>& services);
-   static void parseSolution(std::ifstream& file,
+   static void parseSolution(Tokenizer& file,
                              std::vector<int> * assignment);
-   static void parseProcesses(std::ifstream& file, int numResources,
+   static void parseProcesses(Tokenizer& file, int numResources,
                               std::vector<inst::Process>& processes);
    static void parseBalanceCosts(
-      std::ifstream& file,
+      Tokenizer& file,
       std::vector<inst::BalanceCost>& balanceCosts);
-   static void parseWeights(std::ifstream& file, int& processMoveCostWeight,
+   static void parseWeights(Tokenizer& file, int& processMoveCostWeight,
                             int& serviceMoveCostWeight,
                             int& machineMoveCostWeight);
 };
 
 template <class OutputIterator>
-void Parser::fillArray(std::ifstream& file, int size, OutputIterator result)
+void Parser::fillArray(Tokenizer& file, int size, OutputIterator result)
 {
    for (int i = 0; i < size; i++)
    {
-      int value;
-
-      file >> value;
-
-      *result = value;
+      *result = file.nextInteger();
    }
 }
 
@@ -9,6 +9,8 @@
 #include <boost/thread/mutex.hpp>
 #include <list>
 
+// The solutions are kept as snapshots, ordered by increasing
+// objective value.
 class Pool
 {
 public:
@@ -20,23 +22,31 @@ public:
    {
    }
 
-   void addSolution(sol::Solution const & solution)
+   template <typename Solution>
+   void addSolution(Solution const & solution)
    {
+      inst::integer value = solution.objValue().objValue();
+
       if (_pool.size() < _maxNumSolutions)
       {
          insertSolution(solution);
       }
-      else if (solution.objValue().objValue()
-               < _pool.back().objValue().objValue())
+      else if (value < _pool.back().objValue().objValue())
       {
-         bool inserted = insertSolution(solution);
+         std::list<sol::Snapshot>::iterator position;
+
+         if (!findPosition(value, &position))
+            return;
 
-         if (inserted)
-            removeWorst();
+         // Recycle the worst snapshot: assigning over it reuses its
+         // buffer, so a full pool doesn't allocate.
+         std::list<sol::Snapshot>::iterator worst = --_pool.end();
+         worst->assign(solution);
+         _pool.splice(position, _pool, worst);
       }
    }
 
-   sol::Solution getBestSolution() const
+   sol::Snapshot const & getBestSolution() const
    {
       if (_pool.empty())
          throw NoSolution();
@@ -47,39 +57,46 @@ public:
         
 private:
 
-   bool insertSolution(sol::Solution const & solution)
+   template <typename Solution>
+   bool insertSolution(Solution const & solution)
    {
-      int index = 0;
-      for (std::list<sol::Solution>::iterator it = _pool.begin();
+      std::list<sol::Snapshot>::iterator position;
+
+      if (!findPosition(solution.objValue().objValue(), &position))
+         return false;
+
+      _pool.insert(position, sol::Snapshot(solution));
+      return true;
+   }
+
+   // Position (in increasing objective value order) of a solution of
+   // the given value, false if the pool already has a solution with
+   // this value.
+   bool findPosition(inst::integer value,
+                     std::list<sol::Snapshot>::iterator * position)
+   {
+      for (std::list<sol::Snapshot>::iterator it = _pool.begin();
            it != _pool.end();
            ++it)
       {
-         if (solution.objValue().objValue()
-             == it->objValue().objValue())
+         if (value == it->objValue().objValue())
          {
             return false;
          }
          
-         if (solution.objValue().objValue()
-             < it->objValue().objValue())
+         if (value < it->objValue().objValue())
          {
-            _pool.insert(it, sol::Solution(solution));
+            *position = it;
             return true;
          }
-         index++;
       }
       
-      _pool.push_back(solution);
+      *position = _pool.end();
       return true;
    }
       
-   void removeWorst()
-   {
-      _pool.pop_back();
-   }
-
    int _maxNumSolutions;
-   std::list<sol::Solution> _pool;
+   std::list<sol::Snapshot> _pool;
 };
 
 #endif
@@ -19,10 +19,10 @@ public:
    {
    }
 
-   sol::Solution apply(sol::Solution const & solution)
+   // Perturbs the solution in place.
+   template <typename Solution>
+   void apply(Solution & currentSolution)
    {
-      sol::Solution currentSolution(solution);
-         
       int i = 0;
       int numMovedProcess = 0;
 
@@ -46,8 +46,6 @@ public:
          boost::this_thread::interruption_point();
       }
       while (numMovedProcess < _numMoves && i < 1000);
-
-      return currentSolution;
    }
 
 private:
@@ -0,0 +1,82 @@
+#ifndef RELOCATION_COSTS_HPP
+#define RELOCATION_COSTS_HPP
+
+#include "aligned_array.hpp"
+#include "instance.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Relocation cost rows: for a process and every machine, the weighted
+// machine move cost and process move cost of the process being on
+// that machine instead of its initial one. The process and machine
+// move cost delta of moving it from src to dst is then
+// row[dst] - row[src].
+//
+// The rows are built on first use and kept in a direct mapped cache
+// (a slot per process if they all fit) whose size is bounded by a
+// memory budget. The slots are left uninitialized, so that only those
+// in use take memory. A row stays valid until the next call to row().
+class RelocationCosts
+{
+public:
+   RelocationCosts(inst::Instance const & instance, std::size_t budget)
+      : _inst(instance),
+        _numSlots(numSlotsFor(instance, budget)),
+        _slotProcesses(_numSlots, -1),
+        _rows(static_cast<std::size_t>(_numSlots) * instance.numMachines(),
+              AlignedArray<inst::integer>::Uninitialized())
+   {
+   }
+
+   inst::integer const * row(int process)
+   {
+      int slot = process % _numSlots;
+      inst::integer * costs
+         = &_rows[static_cast<std::size_t>(slot) * _inst.numMachines()];
+
+      if (_slotProcesses[slot] != process)
+      {
+         build(process, costs);
+         _slotProcesses[slot] = process;
+      }
+
+      return costs;
+   }
+
+private:
+   static int numSlotsFor(inst::Instance const & instance,
+                          std::size_t budget)
+   {
+      std::size_t rowSize = std::max(1, instance.numMachines())
+         * sizeof(inst::integer);
+
+      return static_cast<int>(
+         std::max<std::size_t>(
+            1, std::min<std::size_t>(budget / rowSize,
+                                     instance.numProcesses())));
+   }
+
+   void build(int process, inst::integer * costs) const
+   {
+      int initMachine = _inst.initAssignment()[process];
+      inst::integer processMoveCost = static_cast<inst::integer>(
+         _inst.process(process).moveCost()) * _inst.processMoveCostWeight();
+
+      for (int i = 0; i < _inst.numMachines(); i++)
+      {
+         costs[i] = _inst.moveCost(initMachine, i)
+            * _inst.machineMoveCostWeight() + processMoveCost;
+      }
+
+      costs[initMachine] = 0;
+   }
+
+   inst::Instance const & _inst;
+   int _numSlots;
+   std::vector<int> _slotProcesses; // slot -> process, -1 if empty
+   AlignedArray<inst::integer> _rows; // slot -> machine
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef SHARED_POOL_HPP
+#define SHARED_POOL_HPP
+
+#include "instance.hpp"
+#include "solution.hpp"
+
+#include <algorithm>
+#include <boost/atomic.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/thread/mutex.hpp>
+#include <limits>
+#include <vector>
+
+// The elite solutions of all the workers, which start their ILS runs
+// from them. The snapshots are ordered by increasing objective value
+// and kept apart from one another: a solution closer than minDistance
+// (Hamming distance) to an elite one only replaces it, and only if it
+// is better.
+//
+// The objective values of the best and of the worst elite solutions
+// are published without the lock, so that a worker can tell whether it
+// has anything to add before taking it.
+class SharedPool
+{
+public:
+   SharedPool(int maxNumSolutions, int minDistance)
+      : _maxNumSolutions(std::max(1, maxNumSolutions)),
+        _minDistance(std::max(1, minDistance)),
+        _bestValue(std::numeric_limits<inst::integer>::max()),
+        _worstValue(std::numeric_limits<inst::integer>::max())
+   {
+   }
+
+   inst::integer bestValue() const
+   {
+      return _bestValue.load(boost::memory_order_acquire);
+   }
+
+   // Returns false if the solution isn't kept.
+   template <typename Solution>
+   bool addSolution(Solution const & solution)
+   {
+      inst::integer value = solution.objValue().objValue();
+
+      // Once the pool is full, the worst value only decreases.
+      if (value >= _worstValue.load(boost::memory_order_acquire))
+         return false;
+
+      sol::Snapshot snapshot(solution);
+
+      boost::mutex::scoped_lock lock(_mutex);
+
+      int closest = -1;
+      int closestDistance = std::numeric_limits<int>::max();
+
+      for (int i = 0; i < _pool.size(); i++)
+      {
+         int distance = snapshot.distance(_pool[i]);
+
+         if (distance < closestDistance)
+         {
+            closest = i;
+            closestDistance = distance;
+         }
+      }
+
+      std::vector<sol::Snapshot>::iterator replaced;
+
+      if (closest >= 0 && closestDistance < _minDistance)
+      {
+         if (value >= _pool[closest].objValue().objValue())
+            return false;
+
+         replaced = _pool.begin() + closest;
+      }
+      else if (_pool.size() < _maxNumSolutions)
+      {
+         _pool.push_back(sol::Snapshot());
+         replaced = _pool.end() - 1;
+      }
+      else if (value < _pool.back().objValue().objValue())
+      {
+         replaced = _pool.end() - 1;
+      }
+      else
+      {
+         return false;
+      }
+
+      // Moves the solution to its position in increasing objective
+      // value order.
+      std::vector<sol::Snapshot>::iterator position = _pool.begin();
+
+      while (position != replaced
+             && position->objValue().objValue() <= value)
+         ++position;
+
+      std::copy_backward(position, replaced, replaced + 1);
+      std::swap(*position, snapshot);
+
+      publish();
+      return true;
+   }
+
+   // Copies the best solution in "snapshot", false if there is none.
+   bool getBestSolution(sol::Snapshot * snapshot)
+   {
+      boost::mutex::scoped_lock lock(_mutex);
+
+      if (_pool.empty())
+         return false;
+
+      *snapshot = _pool.front();
+      return true;
+   }
+
+   // Copies a random elite solution in "snapshot", false if there is
+   // none.
+   bool drawSolution(boost::mt19937 & gen, sol::Snapshot * snapshot)
+   {
+      boost::mutex::scoped_lock lock(_mutex);
+
+      if (_pool.empty())
+         return false;
+
+      boost::uniform_int<int> dist(0, _pool.size() - 1);
+      *snapshot = _pool[dist(gen)];
+      return true;
+   }
+
+private:
+   void publish()
+   {
+      _bestValue.store(_pool.front().objValue().objValue(),
+                       boost::memory_order_release);
+
+      if (_pool.size() == _maxNumSolutions)
+      {
+         _worstValue.store(_pool.back().objValue().objValue(),
+                           boost::memory_order_release);
+      }
+   }
+
+   int _maxNumSolutions;
+   int _minDistance;
+
+   boost::mutex _mutex;
+   std::vector<sol::Snapshot> _pool;
+
+   boost::atomic<inst::integer> _bestValue;
+   boost::atomic<inst::integer> _worstValue;
+};
+
+#endif
@@ -1,5 +1,44 @@
 #include "solution.hpp"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+sol::AssignmentCounts sol::AssignmentCounts::compute(
+   inst::Instance const * inst,
+   std::vector<int> const & assignment,
+   int numThreads)
+{
+   // Below a few thousand processes per thread, starting the threads
+   // and summing their counts costs more than it saves.
+   int const minNumProcessesPerThread = 4096;
+   int numProcesses = assignment.size();
+
+   numThreads = std::max(1, std::min(numThreads,
+                                     numProcesses / minNumProcessesPerThread));
+
+   AssignmentCounts counts(inst);
+   std::vector<AssignmentCounts> partialCounts(numThreads - 1, counts);
+   boost::thread_group threads;
+
+   for (int i = 1; i < numThreads; i++)
+   {
+      threads.create_thread(
+         boost::bind(&AssignmentCounts::count, &partialCounts[i - 1], inst,
+                     boost::cref(assignment),
+                     static_cast<long long>(numProcesses) * i / numThreads,
+                     static_cast<long long>(numProcesses) * (i + 1)
+                     / numThreads));
+   }
+
+   counts.count(inst, assignment, 0, numProcesses / numThreads);
+   threads.join_all();
+
+   for (int i = 0; i < partialCounts.size(); i++)
+      counts.add(partialCounts[i]);
+
+   return counts;
+}
+
 std::ostream& operator<<(std::ostream & out,
                          sol::ObjValue const & objValue)
 {
@@ -7,4 +46,3 @@ std::ostream& operator<<(std::ostream & out,
    
    return out;
 }
-
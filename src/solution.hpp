@@ -1,14 +1,20 @@
 #ifndef SOLUTION_HPP
 #define SOLUTION_HPP
 
-#include "binary_heap.hpp"
+#include "aligned_array.hpp"
+#include "hash_counter.hpp"
 #include "instance.hpp"
+#include "kernels.hpp"
 
 #include <algorithm>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/shared_ptr.hpp>
 #include <functional>
+#include <iostream>
+#include <limits>
 #include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
 namespace sol
@@ -28,6 +34,60 @@ namespace sol
       std::vector<int> assignment;
    };
 
+   // Compile-time properties of the instances handled by a
+   // BasicSolution. With a fixed number of resources, the per-resource
+   // loops have a constant trip count; NumResources == 0 reads it from
+   // the instance. Without transient resources, balance costs or
+   // dependencies, the corresponding tables and checks are compiled
+   // out.
+   template <int NumResources,
+             bool Transient = true,
+             bool Balance = true,
+             bool Dependencies = true>
+   struct Traits
+   {
+      static const int fixedNumResources = NumResources;
+      static const int fixedResourceStride = (NumResources + 3) / 4 * 4;
+
+      static const bool hasTransient = Transient;
+      static const bool hasBalance = Balance;
+      static const bool hasDependencies = Dependencies;
+
+      static int numResources(inst::Instance const * inst)
+      {
+         return NumResources ? NumResources : inst->numResources();
+      }
+
+      static int resourceStride(inst::Instance const * inst)
+      {
+         return NumResources ? fixedResourceStride : inst->resourceStride();
+      }
+
+      // For instance "6 resources, no transient, no dependencies".
+      static std::string name()
+      {
+         std::ostringstream name;
+
+         if (NumResources)
+            name << NumResources << " resources";
+         else
+            name << "any number of resources";
+
+         if (!Transient)
+            name << ", no transient";
+
+         if (!Balance)
+            name << ", no balance";
+
+         if (!Dependencies)
+            name << ", no dependencies";
+
+         return name.str();
+      }
+   };
+
+   typedef Traits<0> DynamicTraits;
+
    class ObjValue
    {
    public:
@@ -63,6 +123,13 @@ namespace sol
          _objValue += delta._objValue;
       }
 
+      // The delta which undoes this one.
+      ObjValue opposite() const
+      {
+         return ObjValue(-_load, -_balance, -_processMove, -_serviceMove,
+                         -_machineMove);
+      }
+
       integer load() const { return _load; }
       integer balance() const { return _balance; }
       integer processMove() const { return _processMove; }
@@ -107,55 +174,146 @@ namespace sol
    };
 
 
-   class MachineUsage
+   // Resource usages and per service counts of an assignment, from
+   // which the incremental structures are built. Each thread counts a
+   // range of processes in its own AssignmentCounts, which are then
+   // summed.
+   struct AssignmentCounts
    {
-   public:
-      MachineUsage(State const & state)
-      : _machineUsage(
-         state.inst->numMachines(),
-         std::vector<integer>(state.inst->numResources(), 0)),
+      AssignmentCounts(inst::Instance const * inst)
+         : stride(inst->resourceStride()),
+           numLocations(inst->numLocations()),
+           numNeighborhoods(inst->numNeighborhoods()),
+           usage(static_cast<size_t>(inst->numMachines()) * stride),
+           usageTransient(static_cast<size_t>(inst->numMachines()) * stride),
+           servLocNumProc(inst->numServices() * numLocations, 0),
+           servNeighNumProc(inst->numServices() * numNeighborhoods, 0),
+           servNumProcMoved(inst->numServices(), 0)
+      {
+      }
+
+      // Counts the processes [begin, end).
+      void count(inst::Instance const * inst,
+                 std::vector<int> const & assignment,
+                 int begin, int end)
+      {
+         for (int i = begin; i < end; i++)
+         {
+            inst::Process const & process = inst->process(i);
+            int machine = assignment[i];
+            int initMachine = inst->initAssignment()[i];
+            int service = process.service();
+            integer const * requirements = process.requirements();
 
-        _machineUsageTransient(
-           state.inst->numMachines(),
-           std::vector<integer>(state.inst->numResources(), 0)),
+            integer * machineUsage = &usage[machine * stride];
+            integer * machineUsageTransient = &usageTransient[machine * stride];
+
+            for (int j = 0; j < inst->numResources(); j++)
+            {
+               machineUsage[j] += requirements[j];
+               machineUsageTransient[j] += requirements[j];
+            }
 
-        _overSafetyCapacity(
-           state.inst->numMachines(),
-           std::vector<integer>(state.inst->numResources(), 0)),
+            // A moved process still uses the transient resources of
+            // its initial machine.
+            if (machine != initMachine)
+            {
+               integer * initUsageTransient
+                  = &usageTransient[initMachine * stride];
+
+               for (int j = 0; j < inst->numResources(); j++)
+               {
+                  if (inst->resource(j).transient())
+                     initUsageTransient[j] += requirements[j];
+               }
+
+               servNumProcMoved[service]++;
+            }
 
-        _underSafetyCapacity(
-           state.inst->numMachines(),
-           std::vector<integer>(state.inst->numResources(), 0))
+            inst::Machine const & machineObj = inst->machine(machine);
 
+            servLocNumProc[service * numLocations + machineObj.location()]++;
+            servNeighNumProc[service * numNeighborhoods
+                             + machineObj.neighborhood()]++;
+         }
+      }
+
+      void add(AssignmentCounts const & other)
       {
-         for (int i = 0; i < state.assignment.size(); i++)
+         for (size_t i = 0; i < usage.size(); i++)
          {
-            int process = i;
-            int machine = state.assignment[i];
+            usage[i] += other.usage[i];
+            usageTransient[i] += other.usageTransient[i];
+         }
+
+         for (size_t i = 0; i < servLocNumProc.size(); i++)
+            servLocNumProc[i] += other.servLocNumProc[i];
+
+         for (size_t i = 0; i < servNeighNumProc.size(); i++)
+            servNeighNumProc[i] += other.servNeighNumProc[i];
+
+         for (size_t i = 0; i < servNumProcMoved.size(); i++)
+            servNumProcMoved[i] += other.servNumProcMoved[i];
+      }
+
+      // Counts the whole assignment using up to numThreads threads.
+      static AssignmentCounts compute(inst::Instance const * inst,
+                                      std::vector<int> const & assignment,
+                                      int numThreads);
+
+      int stride;
+      int numLocations;
+      int numNeighborhoods;
 
-            for (int j = 0; j < state.inst->numResources(); j++)
+      AlignedArray<integer> usage;           // machine x stride
+      AlignedArray<integer> usageTransient;  // machine x stride
+      std::vector<int> servLocNumProc;       // service x location
+      std::vector<int> servNeighNumProc;     // service x neighborhood
+      std::vector<int> servNumProcMoved;     // service
+   };
+
+   // The state of a machine is stored as one record of four
+   // consecutive rows (usage, usage with transient, over safety
+   // capacity, under safety capacity), each resourceStride() long, so
+   // that all the state of a machine is adjacent in memory.
+   template <typename Traits>
+   class MachineUsage
+   {
+   public:
+      MachineUsage(State const & state, AssignmentCounts const & counts)
+      : _stride(Traits::resourceStride(state.inst)),
+        _records(static_cast<size_t>(state.inst->numMachines())
+                 * numRows * _stride)
+      {
+         for (int i = 0; i < state.inst->numMachines(); i++)
+         {
+            std::copy(&counts.usage[i * _stride],
+                      &counts.usage[i * _stride] + _stride,
+                      row(i, usageRow));
+
+            if (Traits::hasTransient)
             {
-               int resource = j;
-               integer requirement
-                  = state.inst->process(process).requirement(resource);
-               
-               _machineUsage[machine][resource] += requirement;
-               _machineUsageTransient[machine][resource] += requirement;
+               std::copy(&counts.usageTransient[i * _stride],
+                         &counts.usageTransient[i * _stride] + _stride,
+                         row(i, usageTransientRow));
             }
          }
 
          for (int i = 0; i < state.inst->numMachines(); i++)
          {
+            integer const * usage = row(i, usageRow);
+            integer * overSafetyCapacity = row(i, overSafetyCapacityRow);
+            integer * underSafetyCapacity = row(i, underSafetyCapacityRow);
 
-            for (int j = 0; j < state.inst->numResources(); j++)
+            for (int j = 0; j < Traits::numResources(state.inst); j++)
             {
                integer safetyCapacity
                   = state.inst->machine(i).safetyCapacity(j);
 
-               _overSafetyCapacity[i][j] = _machineUsage[i][j] - safetyCapacity;
+               overSafetyCapacity[j] = usage[j] - safetyCapacity;
 
-               if (_overSafetyCapacity[i][j] <= 0)
-                  _underSafetyCapacity[i][j] = -_overSafetyCapacity[i][j];
+               if (overSafetyCapacity[j] <= 0)
+                  underSafetyCapacity[j] = -overSafetyCapacity[j];
             }
          }
       }
@@ -163,23 +321,37 @@ namespace sol
       void moveProcess(State const & state, int process, int srcMachine,
                        int dstMachine)
       {
-         for (int i = 0; i < state.inst->numResources(); i++)
+         integer * srcUsage = row(srcMachine, usageRow);
+         integer * dstUsage = row(dstMachine, usageRow);
+         integer * srcUsageTransient = row(srcMachine, usageTransientRow);
+         integer * dstUsageTransient = row(dstMachine, usageTransientRow);
+         integer * srcOverSafetyCapacity
+            = row(srcMachine, overSafetyCapacityRow);
+         integer * dstOverSafetyCapacity
+            = row(dstMachine, overSafetyCapacityRow);
+         integer * srcUnderSafetyCapacity
+            = row(srcMachine, underSafetyCapacityRow);
+         integer * dstUnderSafetyCapacity
+            = row(dstMachine, underSafetyCapacityRow);
+
+         for (int i = 0; i < Traits::numResources(state.inst); i++)
          {
             integer requirement = state.inst->process(process).requirement(i);
             
-            _machineUsage[srcMachine][i] -= requirement;
-            _machineUsage[dstMachine][i] += requirement;
+            srcUsage[i] -= requirement;
+            dstUsage[i] += requirement;
+
+            srcOverSafetyCapacity[i] -= requirement;
+            dstOverSafetyCapacity[i] += requirement;
 
-            _overSafetyCapacity[srcMachine][i] -= requirement;
-            _overSafetyCapacity[dstMachine][i] += requirement;
+            srcUnderSafetyCapacity[i] 
+               = std::max(static_cast<integer>(0), -srcOverSafetyCapacity[i]);
 
-            _underSafetyCapacity[srcMachine][i] 
-               = std::max(static_cast<integer>(0),
-                          -_overSafetyCapacity[srcMachine][i]);
+            dstUnderSafetyCapacity[i] 
+               = std::max(static_cast<integer>(0), -dstOverSafetyCapacity[i]);
 
-            _underSafetyCapacity[dstMachine][i] 
-               = std::max(static_cast<integer>(0),
-                          -_overSafetyCapacity[dstMachine][i]);
+            if (!Traits::hasTransient)
+               continue;
 
             if (state.inst->resource(i).transient())
             {
@@ -191,68 +363,91 @@ namespace sol
 
                if (!initialSrcMachine)
                {
-                  _machineUsageTransient[srcMachine][i] -= requirement;
+                  srcUsageTransient[i] -= requirement;
                }
 
                if (!initialDstMachine)
                {
-                  _machineUsageTransient[dstMachine][i] += requirement;
+                  dstUsageTransient[i] += requirement;
                }
             }
             else
             {
-               _machineUsageTransient[srcMachine][i] -= requirement;
-               _machineUsageTransient[dstMachine][i] += requirement;
+               srcUsageTransient[i] -= requirement;
+               dstUsageTransient[i] += requirement;
             }
          }
       }
 
-      std::vector<std::vector<integer> > const & usages() const
-      { return _machineUsage; }
-
-      std::vector<integer> const & usage(int machine) const
+      integer const * usage(int machine) const
       {
-         return _machineUsage[machine];
+         return row(machine, usageRow);
       }
 
-      std::vector<integer> const & usageWithTransient(int machine) const
+      integer const * usageWithTransient(int machine) const
       {
-         return _machineUsageTransient[machine];
+         return row(machine, usageTransientRow);
       }
 
-      std::vector<integer> const & overSafetyCapacity(int machine) const
+      integer const * overSafetyCapacity(int machine) const
       {
-         return _overSafetyCapacity[machine];
+         return row(machine, overSafetyCapacityRow);
       }
 
-      std::vector<integer> const & underSafetyCapacity(int machine) const
+      integer const * underSafetyCapacity(int machine) const
       {
-         return _underSafetyCapacity[machine];
+         return row(machine, underSafetyCapacityRow);
       }
 
       
    private:
-      // machine -> resource
-      std::vector<std::vector<integer> > _machineUsage;
+      // Without transient resources, the usage with transient is the
+      // usage: it has no row of its own.
+      static const int usageRow = 0;
+      static const int usageTransientRow = Traits::hasTransient ? 1 : 0;
+      // can be negative
+      static const int overSafetyCapacityRow = usageTransientRow + 1;
+      // non negative, under = max(0, -over)
+      static const int underSafetyCapacityRow = usageTransientRow + 2;
+      static const int numRows = usageTransientRow + 3;
+
+      integer * row(int machine, int row)
+      {
+         return &_records[(static_cast<size_t>(machine) * numRows + row)
+                          * stride()];
+      }
 
-      // machine -> resource
-      std::vector<std::vector<integer> > _machineUsageTransient; 
+      integer const * row(int machine, int row) const
+      {
+         return &_records[(static_cast<size_t>(machine) * numRows + row)
+                          * stride()];
+      }
+
+      int stride() const
+      {
+         return Traits::fixedResourceStride
+            ? Traits::fixedResourceStride : _stride;
+      }
 
-      // machine -> over safety capacity (can be negative)
-      std::vector<std::vector<integer> > _overSafetyCapacity; 
+      int _stride;
 
-      // machine -> under safety capacity (non negative, under =
-      // max(0, -over))
-      std::vector<std::vector<integer> > _underSafetyCapacity; 
+      // machine -> (usage, usage with transient, over safety capacity,
+      // under safety capacity) -> resource
+      AlignedArray<integer> _records;
    };
 
    class LoadCost
    {
    public:
+      LoadCost(State const & state)
+         : _kernels(&kernels::select(*state.inst))
+      {
+      }
 
+      template <typename MachineUsage>
       integer computeObjValue(
          State const & state,
-         std::vector<std::vector<integer> > const & machinesUsage)
+         MachineUsage const & machinesUsage)
       {
          integer objValue = 0;
          
@@ -267,7 +462,7 @@ namespace sol
 
                integer capacity
                   = state.inst->machine(machine).capacity(resource);
-               integer usage    = machinesUsage[machine][resource];
+               integer usage    = machinesUsage.usage(machine)[resource];
                integer safetyCap
                   = state.inst->machine(machine).safetyCapacity(resource);
                
@@ -287,67 +482,89 @@ namespace sol
       integer evaluateMoveProcess(
          State const & state, int process,
          int srcMachine, int dstMachine,
-         std::vector<integer> const & srcMachineUsage,
-         std::vector<integer> const & dstMachineUsage,
-         std::vector<integer> const & srcMachineOverSafetyCapacity,
-         std::vector<integer> const & dstMachineUnderSafetyCapacity) const
+         integer const * srcMachineUsage,
+         integer const * dstMachineUsage,
+         integer const * srcMachineOverSafetyCapacity,
+         integer const * dstMachineUnderSafetyCapacity) const
       {
-         integer deltaObjValue = 0;
+         return _kernels->loadCostDelta(
+            state.inst->resourceStride(),
+            state.inst->process(process).requirements(),
+            state.inst->resourcesLoadCostWeight(),
+            srcMachineOverSafetyCapacity,
+            dstMachineUnderSafetyCapacity);
+      }
 
-         std::vector<integer> const & requirements 
+      // The part of evaluateMoveProcess due to the source machine: the
+      // delta of a move is this plus a non negative destination part.
+      integer evaluateRemoveProcess(
+         State const & state, int process,
+         integer const * srcMachineOverSafetyCapacity) const
+      {
+         integer const * requirements
             = state.inst->process(process).requirements();
+         integer const * weights = state.inst->resourcesLoadCostWeight();
+         integer deltaObjValue = 0;
 
-         std::vector<integer> const & resourcesLoadCostWeight 
-            = state.inst->resourcesLoadCostWeight();
-
-         int numResources = state.inst->numResources();
-
-         for (int i = 0; i < numResources; i++)
+         for (int i = 0; i < state.inst->numResources(); i++)
          {
-            // Common
-            integer loadCostWeight = resourcesLoadCostWeight[i];
-            integer processRequirement = requirements[i];
-
-            {
-               // Source
-               integer overSafetyCapacity = srcMachineOverSafetyCapacity[i];
-               
-               if (overSafetyCapacity > 0)
-               {
-                  integer deltaSafetyCapacity
-                     = std::min(overSafetyCapacity, processRequirement);
-                  
-                  deltaObjValue -= loadCostWeight * deltaSafetyCapacity;
-               }
-            }
-
-            {
-               // Destination            
-               integer underSafetyCapacity = dstMachineUnderSafetyCapacity[i];
-               
-               integer deltaSafetyCapacity 
-                  = std::max(static_cast<integer>(0),
-                             processRequirement - underSafetyCapacity);
-               
-               if (deltaSafetyCapacity)
-                  deltaObjValue += loadCostWeight * deltaSafetyCapacity;
-            }
+            deltaObjValue -= weights[i] * std::max(
+               static_cast<integer>(0),
+               std::min(srcMachineOverSafetyCapacity[i], requirements[i]));
          }
 
          return deltaObjValue;
       }
+
+      // Capacity::isFeasible and evaluateMoveProcess in a single pass
+      // over the resources: false if the process doesn't fit in the
+      // destination machine, otherwise the delta is set.
+      bool evaluateMoveProcessIfFits(
+         State const & state, int process, bool toInitMachine,
+         integer const * srcMachineOverSafetyCapacity,
+         integer const * dstMachineUsageTransient,
+         integer const * dstCapacities,
+         integer const * dstMachineUnderSafetyCapacity,
+         integer * deltaObjValue) const
+      {
+         return _kernels->fitsLoadCostDelta(
+            state.inst->resourceStride(),
+            state.inst->process(process).requirements(),
+            state.inst->resourcesLoadCostWeight(),
+            state.inst->transientMask(),
+            toInitMachine,
+            srcMachineOverSafetyCapacity,
+            dstMachineUsageTransient,
+            dstCapacities,
+            dstMachineUnderSafetyCapacity,
+            deltaObjValue);
+      }
+
+   private:
+      kernels::Kernels const * _kernels;
    };
 
    class Balance
    {
    public:
-      Balance()
+      Balance(State const & state)
+         : _kernels(&kernels::select(*state.inst))
       {
+         for (int i = 0; i < state.inst->numBalanceCosts(); i++)
+         {
+            inst::BalanceCost const & balanceCost = state.inst->balanceCost(i);
+
+            _firstResources.push_back(balanceCost.firstResource());
+            _secondResources.push_back(balanceCost.secondResource());
+            _targets.push_back(balanceCost.target());
+            _weights.push_back(balanceCost.weight());
+         }
       }
 
+      template <typename MachineUsage>
       integer computeObjValue(
          State const & state,
-         std::vector<std::vector<integer> > const & machinesUsage)
+         MachineUsage const & machinesUsage)
       {
          integer objValue = 0;
          
@@ -366,14 +583,14 @@ namespace sol
                      balanceCost.firstResource());
                
                integer usageFirstRes
-                  = machinesUsage[machine][balanceCost.firstResource()];
+                  = machinesUsage.usage(machine)[balanceCost.firstResource()];
 
                integer capacitySecondRes
                   = state.inst->machine(machine).capacity(
                      balanceCost.secondResource());
                
                integer usageSecondRes
-                  = machinesUsage[machine][balanceCost.secondResource()];
+                  = machinesUsage.usage(machine)[balanceCost.secondResource()];
 
 
                balanceObjValue
@@ -398,173 +615,88 @@ namespace sol
          int process,
          int srcMachine,
          int dstMachine,
-         std::vector<integer> const & srcMachineUsage,
-         std::vector<integer> const & dstMachineUsage) const
+         integer const * srcMachineUsage,
+         integer const * dstMachineUsage) const
       {
-         integer deltaObjValue = 0;
-
-         for (int i = 0; i < state.inst->numBalanceCosts(); i++)
-         {
-            integer delta = 0;
-            inst::BalanceCost const & balanceCost = state.inst->balanceCost(i);
-
-            int firstRes = balanceCost.firstResource();
-            int secondRes = balanceCost.secondResource();
-            
-            // Source            
-                         
-            integer deltaFirstResSrc = deltaResourceRemove(
-               state,
-               process,
-               srcMachine,
-               balanceCost.firstResource(),
-               srcMachineUsage);
-
-            integer deltaSecondResSrc = deltaResourceRemove(
-               state,
-               process,
-               srcMachine,
-               balanceCost.secondResource(),
-               srcMachineUsage);
-
-            integer remainingFirstResBeforeSrc
-               = std::max(static_cast<inst::integer>(0),
-                          state.inst->machine(srcMachine)
-                          .capacity(firstRes) - srcMachineUsage[firstRes]);
-            
-            integer remainingSecondResBeforeSrc
-               = std::max(static_cast<inst::integer>(0),
-                          state.inst->machine(srcMachine)
-                          .capacity(secondRes)
-                          - srcMachineUsage[secondRes]);
-
-            integer remainingFirstResAfterSrc
-               = remainingFirstResBeforeSrc - deltaFirstResSrc;
-
-            integer remainingSecondResAfterSrc
-               = remainingSecondResBeforeSrc - deltaSecondResSrc;
-
-            
-            
-            integer valueBeforeSrc = 
-               std::max(static_cast<inst::integer>(0),
-                          balanceCost.target() * remainingFirstResBeforeSrc
-                          - remainingSecondResBeforeSrc);
-
-            integer valueAfterSrc = 
-               std::max(static_cast<inst::integer>(0),
-                          balanceCost.target() * remainingFirstResAfterSrc
-                          - remainingSecondResAfterSrc);
-
-            
-            delta += valueAfterSrc - valueBeforeSrc;
-
-
-            // Destination
-
-            integer deltaFirstResDst = deltaResourceAdd(
-               state,
-               process,
-               dstMachine,
-               balanceCost.firstResource(),
-               dstMachineUsage);
-
-            integer deltaSecondResDst = deltaResourceAdd(
-               state,
-               process,
-               dstMachine,
-               balanceCost.secondResource(),
-               dstMachineUsage);
-
-
-            integer remainingFirstResBeforeDst
-               = std::max(static_cast<inst::integer>(0),
-                          state.inst->machine(dstMachine)
-                          .capacity(firstRes) - dstMachineUsage[firstRes]);
-            
-            integer remainingSecondResBeforeDst
-               = std::max(static_cast<inst::integer>(0),
-                          state.inst->machine(dstMachine)
-                          .capacity(secondRes)
-                          - dstMachineUsage[secondRes]);
-
-            integer remainingFirstResAfterDst
-               = remainingFirstResBeforeDst - deltaFirstResDst;
-
-            integer remainingSecondResAfterDst
-               = remainingSecondResBeforeDst - deltaSecondResDst;
-            
-            integer valueBeforeDst = /* balanceCost.weight()
-                                      * */
-               std::max(static_cast<inst::integer>(0),
-                          balanceCost.target() * remainingFirstResBeforeDst
-                          - remainingSecondResBeforeDst);
-
-            integer valueAfterDst = 
-               std::max(static_cast<inst::integer>(0),
-                          balanceCost.target() * remainingFirstResAfterDst
-                          - remainingSecondResAfterDst);
-
+         if (_targets.empty())
+            return 0;
+
+         kernels::BalanceCosts balanceCosts = {
+            static_cast<int>(_targets.size()),
+            &_firstResources[0],
+            &_secondResources[0],
+            &_targets[0],
+            &_weights[0]
+         };
+
+         return _kernels->balanceDelta(
+            balanceCosts,
+            state.inst->process(process).requirements(),
+            srcMachineUsage,
+            state.inst->machine(srcMachine).capacities(),
+            dstMachineUsage,
+            state.inst->machine(dstMachine).capacities());
+      }
 
-            delta += valueAfterDst - valueBeforeDst;
+      // Lower bound of evaluateMoveProcess from the source machine to
+      // any destination. The source part is exact; adding the process
+      // to a machine lowers its balance value by at most the target
+      // times the requirement of the first resource.
+      integer lowerBoundMoveProcess(State const & state, int process,
+                                    int srcMachine,
+                                    integer const * srcMachineUsage) const
+      {
+         integer const * requirements
+            = state.inst->process(process).requirements();
+         integer const * capacities
+            = state.inst->machine(srcMachine).capacities();
+         integer bound = 0;
 
-            deltaObjValue += balanceCost.weight() * delta;
+         for (int i = 0; i < _targets.size(); i++)
+         {
+            int first = _firstResources[i];
+            int second = _secondResources[i];
+
+            integer delta
+               = value(_targets[i],
+                       capacities[first],
+                       srcMachineUsage[first] - requirements[first],
+                       capacities[second],
+                       srcMachineUsage[second] - requirements[second])
+               - value(_targets[i],
+                       capacities[first], srcMachineUsage[first],
+                       capacities[second], srcMachineUsage[second])
+               - _targets[i] * requirements[first];
+
+            bound += _weights[i] * delta;
          }
 
-         return deltaObjValue;
+         return bound;
       }
 
    private:
-      
-      integer deltaResourceRemove(
-         State const & state,
-         int process,
-         int machine,
-         int resource,
-         std::vector<integer> const & machineUsage) const
+      // max(0, target x remaining first resource - remaining second
+      // resource), where remaining is max(0, capacity - usage).
+      static integer value(integer target,
+                           integer capacityFirst, integer usageFirst,
+                           integer capacitySecond, integer usageSecond)
       {
-         integer overUsage = std::max(
-            static_cast<integer>(0),
-            machineUsage[resource] -
-            state.inst->machine(machine).capacity(resource));
-
-
-         integer requirement
-            = state.inst->process(process).requirement(resource);
-         
-         integer delta
-            = std::min(
-	       static_cast<integer>(0),
-	       overUsage - requirement);
+         integer remainingFirst
+            = std::max(static_cast<integer>(0), capacityFirst - usageFirst);
+         integer remainingSecond
+            = std::max(static_cast<integer>(0), capacitySecond - usageSecond);
 
-         return delta;
+         return std::max(static_cast<integer>(0),
+                         target * remainingFirst - remainingSecond);
       }
 
-      integer deltaResourceAdd(
-         State const & state,
-         int process,
-         int machine,
-         int resource,
-         std::vector<integer> const & machineUsage) const
-      {
-         integer underUsage = std::max(
-            static_cast<integer>(0),
-            state.inst->machine(machine).capacity(resource)
-            - machineUsage[resource]);
-
-         
-
-         integer requirement
-            = state.inst->process(process).requirement(resource);
-
-         integer delta = std::min(
-            underUsage,
-            requirement);
-
+      kernels::Kernels const * _kernels;
 
-
-         return delta;
-      }
+      // The balance costs as parallel arrays.
+      std::vector<int> _firstResources;
+      std::vector<int> _secondResources;
+      std::vector<integer> _targets;
+      std::vector<integer> _weights;
    };
 
    class ProcessMove
@@ -594,15 +726,28 @@ namespace sol
          int srcMachine,
          int dstMachine) const
       {
-         integer deltaObjValue = 0;
-
          int initMachine = state.inst->initAssignment()[process];
 
-         if (srcMachine == initMachine)
+         return evaluateMoveProcess(state, process,
+                                    srcMachine == initMachine,
+                                    dstMachine == initMachine);
+      }
+
+      // Same, knowing whether the process leaves or returns to its
+      // initial machine.
+      integer evaluateMoveProcess(
+         State const & state,
+         int process,
+         bool fromInitMachine,
+         bool toInitMachine) const
+      {
+         integer deltaObjValue = 0;
+
+         if (fromInitMachine)
          {
             deltaObjValue += state.inst->process(process).moveCost();
          }
-         else if (dstMachine == initMachine)
+         else if (toInitMachine)
          {
             deltaObjValue -= state.inst->process(process).moveCost();
          }
@@ -613,75 +758,30 @@ namespace sol
       }
    };
 
+   // The service move cost is the largest number of moved processes
+   // of a service. The counts only change by one, so a histogram of
+   // the counts tracks the maximum in constant time.
    class ServiceMove
    {
-      class ServiceNode
+   public:
+      ServiceMove(State const & state, AssignmentCounts const & counts)
+         : _numProcMoved(counts.servNumProcMoved),
+           _maxNumProcMoved(0)
       {
-      public:
-         ServiceNode() : _numProcMoved(0), _heapPosition(-1)
-         {
-         }
+         std::size_t maxServiceSize = 0;
 
-         int numProcMoved() const { return _numProcMoved; }
-         
-         void decNumProMoved() { _numProcMoved--; }
-         void incNumProMoved() { _numProcMoved++; }
-
-         int heapPosition() const { return _heapPosition; }
-         
-         void setHeapPosition(int heapPosition)
-         { _heapPosition = heapPosition; }
-         
-      private:
-         int _numProcMoved;
-         int _heapPosition;
-      };
-
-      class CompareServiceNode
-      {
-      public:
-         
-         CompareServiceNode(std::vector<ServiceNode> const & services)
-            : _services(services)
-         {
-         }
-            
-         bool operator()(int a, int b)
+         for (int i = 0; i < state.inst->numServices(); i++)
          {
-            return _services[a].numProcMoved() < _services[b].numProcMoved();
+            maxServiceSize = std::max(
+               maxServiceSize, state.inst->service(i).processes().size());
          }
-         
-      private:
-         std::vector<ServiceNode> const & _services;
-      };
 
-      class UpdateServiceNodePos
-      {
-      public:
-         UpdateServiceNodePos(std::vector<ServiceNode> & services)
-            : _services(services)
-         {
-         }
+         _numServicesPerCount.resize(maxServiceSize + 1, 0);
 
-         void operator()(int service, int heapPosition)
+         for (int i = 0; i < _numProcMoved.size(); i++)
          {
-            _services[service].setHeapPosition(heapPosition);
-         }
-         
-      private:
-         std::vector<ServiceNode> & _services;         
-      };
-      
-   public:
-      ServiceMove(State const & state)
-         : _firstChild(std::min(1, state.inst->numServices() - 1)),
-           _secondChild(std::min(2, state.inst->numServices() - 1))
-      {
-         for (int i = 0; i < state.inst->numServices(); i++)
-         {
-            _services.push_back(ServiceNode());
-            _services[i].setHeapPosition(i);
-            _heap.push_back(i);
+            _numServicesPerCount[_numProcMoved[i]]++;
+            _maxNumProcMoved = std::max(_maxNumProcMoved, _numProcMoved[i]);
          }
       }
 
@@ -711,42 +811,40 @@ namespace sol
          int srcMachine,
          int dstMachine) const
       {
-         
-         integer deltaObjValue = 0;
-
-         int service = state.inst->process(process).service();
          int initMachine = state.inst->initAssignment()[process];
 
+         return evaluateMoveProcess(state,
+                                    state.inst->process(process).service(),
+                                    srcMachine == initMachine,
+                                    dstMachine == initMachine);
+      }
 
-         int numProcMoved = _services[service].numProcMoved();
-         int bestNumProcMoved = _services[_heap[0]].numProcMoved();
+      // Same, for a process of the service, knowing whether it leaves
+      // or returns to its initial machine.
+      integer evaluateMoveProcess(
+         State const & state,
+         int service,
+         bool fromInitMachine,
+         bool toInitMachine) const
+      {
+         if (_numProcMoved[service] != _maxNumProcMoved)
+            return 0;
 
-         if (srcMachine == initMachine)
+         if (fromInitMachine)
          {
             // Increment
-
-            if (numProcMoved == bestNumProcMoved)
-            {
-               deltaObjValue += state.inst->serviceMoveCostWeight();
-            }
+            return state.inst->serviceMoveCostWeight();
          }
-         else if (dstMachine == initMachine)
-         {
-            // Decrement
 
-            if (numProcMoved == bestNumProcMoved)
-            {
-               if (_services[_heap[_firstChild]].numProcMoved()
-                   < bestNumProcMoved &&
-                   _services[_heap[_secondChild]].numProcMoved()
-                   < bestNumProcMoved)
-               {
-                  deltaObjValue -= state.inst->serviceMoveCostWeight();
-               }
-            }
+         if (toInitMachine
+             && _numServicesPerCount[_maxNumProcMoved] == 1)
+         {
+            // Decrement of the only service with the most moved
+            // processes.
+            return -state.inst->serviceMoveCostWeight();
          }
 
-         return deltaObjValue;         
+         return 0;
       }
 
 
@@ -757,41 +855,35 @@ namespace sol
       {
          int service = state.inst->process(process).service();
          int initMachine = state.inst->initAssignment()[process];
+         int & numProcMoved = _numProcMoved[service];
 
          if (srcMachine == initMachine)
          {
-            
-            _services[service].incNumProMoved();
-
-            
-            update_heap_pos(_heap.begin(), _heap.end(),
-                            _heap.begin() + _services[service].heapPosition(),
-                            CompareServiceNode(_services),
-                            UpdateServiceNodePos(_services));
-
-            
+            _numServicesPerCount[numProcMoved]--;
+            numProcMoved++;
+            _numServicesPerCount[numProcMoved]++;
 
+            _maxNumProcMoved = std::max(_maxNumProcMoved, numProcMoved);
          }
          else if (dstMachine == initMachine)
          {
-            
-            _services[service].decNumProMoved();
-            update_heap_pos(_heap.begin(), _heap.end(),
-                            _heap.begin() + _services[service].heapPosition(),
-                            CompareServiceNode(_services),
-                            UpdateServiceNodePos(_services));
-            
+            _numServicesPerCount[numProcMoved]--;
+
+            if (numProcMoved == _maxNumProcMoved
+                && _numServicesPerCount[numProcMoved] == 0)
+               _maxNumProcMoved--;
+
+            numProcMoved--;
+            _numServicesPerCount[numProcMoved]++;
          }
       }
 
 
    private:
 
-      std::vector<ServiceNode> _services;
-      std::vector<int> _heap;
-
-      int _firstChild;
-      int _secondChild;
+      std::vector<int> _numProcMoved; // service
+      std::vector<int> _numServicesPerCount; // num processes moved
+      int _maxNumProcMoved;
    };
 
    class MachineMove
@@ -804,8 +896,8 @@ namespace sol
 
          for (int i = 0; i < state.inst->numProcesses(); i++)
          {
-            objValue += state.inst->machine(state.inst->initAssignment()[i])
-               .moveCost(state.assignment[i]);
+            objValue += state.inst->moveCost(state.inst->initAssignment()[i],
+                                             state.assignment[i]);
          }
 
          objValue *= state.inst->machineMoveCostWeight();
@@ -825,19 +917,17 @@ namespace sol
 
          if (srcMachine == initMachine)
          {
-            deltaObjValue += state.inst->machine(initMachine).
-               moveCost(dstMachine);
+            deltaObjValue += state.inst->moveCost(initMachine, dstMachine);
          }
          else if (dstMachine == initMachine)
          {
-            deltaObjValue -= state.inst->machine(initMachine).
-               moveCost(srcMachine);
+            deltaObjValue -= state.inst->moveCost(initMachine, srcMachine);
          }
          else
          {
             deltaObjValue
-               += -state.inst->machine(initMachine).moveCost(srcMachine)
-               + state.inst->machine(initMachine).moveCost(dstMachine);
+               += -state.inst->moveCost(initMachine, srcMachine)
+               + state.inst->moveCost(initMachine, dstMachine);
          }
 
 
@@ -853,63 +943,70 @@ namespace sol
    {
    public:
       Capacity(State const & state)
+         : _kernels(&kernels::select(*state.inst))
       {
-         
       }
 
       bool isFeasible(State const & state, int process,
                       int srcMachine, int dstMachine,
-                      std::vector<integer> const & srcMachineUsage,
-                      std::vector<integer> const & dstMachineUsage,
-                      std::vector<integer> const & requirements,
-                      std::vector<integer> const & srcCapacities,
-                      std::vector<integer> const & dstCapacities)
-      {
-         std::vector<unsigned char> const & isTransient
-            = state.inst->isTransient();
-         
-         std::vector<int> const & initAssignment
-            = state.inst->initAssignment();
-         
-         bool isInitialDstMachine
-            = (dstMachine == initAssignment[process]);
-         
-         int numResources = state.inst->numResources();
-         for (int i = 0; i < numResources; i++)
-         {
-            if (!(isTransient[i] && isInitialDstMachine))
-            {
-               if ((dstMachineUsage[i] + requirements[i]) > dstCapacities[i])
-                  return false;
-            }
-         }
-         return true;
+                      integer const * srcMachineUsage,
+                      integer const * dstMachineUsage,
+                      integer const * requirements,
+                      integer const * srcCapacities,
+                      integer const * dstCapacities)
+      {
+         return isFeasible(state, dstMachineUsage, requirements,
+                           dstCapacities,
+                           dstMachine == state.inst->initAssignment()[process]);
+      }
+
+      // Same, knowing whether the process returns to its initial
+      // machine.
+      bool isFeasible(State const & state,
+                      integer const * dstMachineUsage,
+                      integer const * requirements,
+                      integer const * dstCapacities,
+                      bool toInitMachine) const
+      {
+         return _kernels->fitsCapacity(
+            state.inst->resourceStride(),
+            dstMachineUsage,
+            requirements,
+            dstCapacities,
+            state.inst->transientMask(),
+            toInitMachine);
       }
 
       // Capacity::moveProcess doesn't exist because Capacity doesn't
       // have any state.
+
+   private:
+      kernels::Kernels const * _kernels;
    };
 
+   // Only the (service, machine) pairs with at least one process are
+   // stored, so the memory is proportional to the number of processes
+   // rather than numServices x numMachines.
    class Conflict
    {
    public:
       Conflict(State const & state)
-         : _servMachNumProc(state.inst->numServices(),
-                            std::vector<int>(state.inst->numMachines(), 0))
+         : _numMachines(state.inst->numMachines()),
+           _servMachNumProc(state.inst->numProcesses())
       {
          for (int i = 0; i < state.assignment.size(); i++)
          {
             int service = state.inst->process(i).service();
             int machine = state.assignment[i];
 
-            _servMachNumProc[service][machine]++;
+            _servMachNumProc.increment(key(service, machine));
          }
       }
 
       bool isFeasible(State const & state, int process,
                       int srcMachine, int dstMachine, int service)
       {
-         return _servMachNumProc[service][dstMachine] == 0;
+         return _servMachNumProc.count(key(service, dstMachine)) == 0;
       }
 
       void moveProcess(State const & state, int process, int srcMachine,
@@ -917,29 +1014,35 @@ namespace sol
       {
          int service = state.inst->process(process).service();
 
-         _servMachNumProc[service][srcMachine]--;
-         _servMachNumProc[service][dstMachine]++;
+         _servMachNumProc.decrement(key(service, srcMachine));
+         _servMachNumProc.increment(key(service, dstMachine));
       }
 
    private:
-      std::vector<std::vector<int> > _servMachNumProc; // service -> machine
+      uint64_t key(int service, int machine) const
+      {
+         return static_cast<uint64_t>(service) * _numMachines + machine;
+      }
+
+      int _numMachines;
+      HashCounter _servMachNumProc; // (service, machine) -> num processes
    };
 
    class Spread
    {
    public:
-      Spread(State const & state)
+      Spread(State const & state, AssignmentCounts const & counts)
          : _servLocNumProc(state.inst->numServices(),
                            std::vector<int>(state.inst->numLocations(), 0)),
            _servNumLoc(state.inst->numServices(), 0)
       {
-         for (int i = 0; i < state.assignment.size(); i++)
+         for (int i = 0; i < state.inst->numServices(); i++)
          {
-            int service = state.inst->process(i).service();
-            int machine = state.assignment[i];
-            int location = state.inst->machine(machine).location();
+            std::vector<int>::const_iterator first
+               = counts.servLocNumProc.begin() + i * counts.numLocations;
 
-            _servLocNumProc[service][location]++;
+            std::copy(first, first + counts.numLocations,
+                      _servLocNumProc[i].begin());
          }
 
          for (int i = 0; i < state.inst->numServices(); i++)
@@ -964,19 +1067,32 @@ namespace sol
          if (srcLocation == dstLocation)
             return true;
 
+         return isFeasible(service, srcLocation, dstLocation,
+                           canLeave(state, service, srcLocation));
+      }
+
+      // Whether the service can lose srcLocation: it isn't its last
+      // process there, or the service has more locations than its
+      // minimum spread.
+      bool canLeave(State const & state, int service, int srcLocation) const
+      {
          bool srcLocIsEmpty = _servLocNumProc[service][srcLocation] == 1;
-         bool dstLocIsEmpty = _servLocNumProc[service][dstLocation] == 0;
 
-         integer spreadMin = state.inst->service(service).spreadMin();
-         
-         if (srcLocIsEmpty && !dstLocIsEmpty)
-         {
-            // Service will lost one location, check if it has the
-            // minimum requirement of locations.
-            return _servNumLoc[service] - 1 >= spreadMin;
-         }
+         return !srcLocIsEmpty
+            || _servNumLoc[service] - 1
+               >= state.inst->service(service).spreadMin();
+      }
 
-         return true;
+      // The destination side of isFeasible, given canLeave() for the
+      // source location.
+      bool isFeasible(int service, int srcLocation, int dstLocation,
+                      bool canLeave) const
+      {
+         if (canLeave || srcLocation == dstLocation)
+            return true;
+
+         // Service will lost one location unless it gains one.
+         return _servLocNumProc[service][dstLocation] == 0;
       }
 
 
@@ -1009,19 +1125,18 @@ namespace sol
    class Dependency
    {
    public:
-      Dependency(State const & state)
+      Dependency(State const & state, AssignmentCounts const & counts)
          : _servNeighNumProc(state.inst->numServices(),
                              std::vector<int>(state.inst->numNeighborhoods(),
                                               0))
       {
-         for (int i = 0; i < state.assignment.size(); i++)
+         for (int i = 0; i < state.inst->numServices(); i++)
          {
-            int process = i;
-            int machine = state.assignment[i];
-            int service = state.inst->process(process).service();
-            int neighborhood = state.inst->machine(machine).neighborhood();
+            std::vector<int>::const_iterator first
+               = counts.servNeighNumProc.begin() + i * counts.numNeighborhoods;
 
-            _servNeighNumProc[service][neighborhood]++;
+            std::copy(first, first + counts.numNeighborhoods,
+                      _servNeighNumProc[i].begin());
          }
       }
       
@@ -1034,8 +1149,15 @@ namespace sol
          if (srcNeighborhood == dstNeighborhood)
             return true;
 
-         // Source neighborhood
-         
+         return canLeave(state, service, srcNeighborhood)
+            && canEnter(state, service, dstNeighborhood);
+      }
+
+      // Source neighborhood: if the service leaves it, no service
+      // depending on it may remain.
+      bool canLeave(State const & state, int service,
+                    int srcNeighborhood) const
+      {
          bool lastProcessInNeigh
             = _servNeighNumProc[service][srcNeighborhood] == 1;
 
@@ -1055,8 +1177,14 @@ namespace sol
             }
          }
 
-         // Destination neighborhood
-         
+         return true;
+      }
+
+      // Destination neighborhood: if the service enters it, all the
+      // services it depends on must already be there.
+      bool canEnter(State const & state, int service,
+                    int dstNeighborhood) const
+      {
          bool  firstProcessInNeigh
             = _servNeighNumProc[service][dstNeighborhood] == 0;
 
@@ -1100,18 +1228,94 @@ namespace sol
       
    };
    
-   class Solution 
+   // Moves applied to a Solution, most recent last. The journal
+   // belongs to one Solution: a copy starts with an empty journal (a
+   // moved Solution keeps it).
+   class MoveJournal
+   {
+   public:
+      struct Move
+      {
+         Move(int process, int srcMachine, ObjValue const & deltaObjValue)
+            : process(process),
+              srcMachine(srcMachine),
+              deltaObjValue(deltaObjValue)
+         {
+         }
+
+         int process;
+         int srcMachine;
+         ObjValue deltaObjValue;
+      };
+
+      MoveJournal()
+      {
+      }
+
+      MoveJournal(MoveJournal const &)
+      {
+      }
+
+      MoveJournal & operator=(MoveJournal const &)
+      {
+         _moves.clear();
+         return *this;
+      }
+
+      MoveJournal(MoveJournal &&) = default;
+      MoveJournal & operator=(MoveJournal &&) = default;
+
+      void push(Move const & move) { _moves.push_back(move); }
+      void pop() { _moves.pop_back(); }
+      Move const & back() const { return _moves.back(); }
+      std::size_t size() const { return _moves.size(); }
+
+      // The capacity is kept so that journaling stops allocating once
+      // it has reached its working size.
+      void clear() { _moves.clear(); }
+
+   private:
+      std::vector<Move> _moves;
+   };
+
+   // Outcome of the evaluation of one move by
+   // BasicSolution::evaluateProcessAgainst.
+   struct MoveEvaluation
+   {
+      enum Status
+      {
+         infeasible,
+         bounded,   // its delta can't be lower than the bound
+         evaluated
+      };
+
+      Status status;
+      ObjValue deltaObjValue; // only set if the move is evaluated
+   };
+
+   // A solution and the incremental structures which evaluate the
+   // moves from it. Traits fixes the number of resources, Solution is
+   // the instantiation which reads it from the instance.
+   template <typename Traits>
+   class BasicSolution
    {
    public:
       
-      Solution(inst::Instance const * instance)
-         : _state(instance, instance->initAssignment()),
-           _machineUsage(_state),
-           _serviceMove(_state),
-           _conflict(_state),
-           _spread(_state),
-           _capacity(_state),
-           _dependency(_state)
+      BasicSolution(inst::Instance const * instance)
+         : BasicSolution(instance, instance->initAssignment(), ObjValue())
+      {
+      }
+
+      // Rebuilds the solution with the given assignment, whose
+      // objective value is already known. The processes are counted
+      // by numThreads threads.
+      BasicSolution(inst::Instance const * instance,
+                    std::vector<int> const & assignment,
+                    ObjValue const & objValue,
+                    int numThreads = 1)
+         : BasicSolution(instance, assignment, objValue,
+                    AssignmentCounts::compute(instance, assignment,
+                                              numThreads))
       {
       }
 
@@ -1123,10 +1327,10 @@ namespace sol
       ObjValue computeObjValue()
       {
          integer loadObjValue
-            = _loadCost.computeObjValue(_state, _machineUsage.usages());
+            = _loadCost.computeObjValue(_state, _machineUsage);
 
          integer balanceObjValue
-            = _balance.computeObjValue(_state, _machineUsage.usages());
+            = _balance.computeObjValue(_state, _machineUsage);
 
          integer processMoveObjValue =
             _processMove.computeObjValue(_state);
@@ -1154,16 +1358,16 @@ namespace sol
          if (srcMachine == dstMachine)
             return ObjValue();
 
-         std::vector<integer> const & srcMachineUsage
+         integer const * srcMachineUsage
             = _machineUsage.usage(srcMachine);
          
-         std::vector<integer> const & dstMachineUsage
+         integer const * dstMachineUsage
             = _machineUsage.usage(dstMachine);
 
-         std::vector<integer> const & srcMachineOverSafetyCapacity
+         integer const * srcMachineOverSafetyCapacity
             = _machineUsage.overSafetyCapacity(srcMachine);
          
-         std::vector<integer> const & dstMachineUnderSafetyCapacity
+         integer const * dstMachineUnderSafetyCapacity
             = _machineUsage.underSafetyCapacity(dstMachine);
 
          integer deltaObjValueLoad = _loadCost.evaluateMoveProcess(
@@ -1171,9 +1375,10 @@ namespace sol
             dstMachineUsage, srcMachineOverSafetyCapacity, 
             dstMachineUnderSafetyCapacity);
 
-         integer deltaObjValueBalance = _balance.evaluateMoveProcess(
-            _state, process, srcMachine, dstMachine, srcMachineUsage,
-            dstMachineUsage);
+         integer deltaObjValueBalance = !Traits::hasBalance ? 0
+            : _balance.evaluateMoveProcess(
+               _state, process, srcMachine, dstMachine, srcMachineUsage,
+               dstMachineUsage);
 
          integer deltaObjValueProcessMove = _processMove.evaluateMoveProcess(
             _state, process, srcMachine, dstMachine);
@@ -1200,10 +1405,10 @@ namespace sol
          if (srcMachine == dstMachine)
             return true;
 
-         std::vector<integer> const & srcMachineUsageTransient
+         integer const * srcMachineUsageTransient
             = _machineUsage.usageWithTransient(srcMachine);
          
-         std::vector<integer> const & dstMachineUsageTransient
+         integer const * dstMachineUsageTransient
             = _machineUsage.usageWithTransient(dstMachine);
 
          inst::Process const & processObj = _state.inst->process(process);
@@ -1224,14 +1429,14 @@ namespace sol
          if (!spreadFeasible)
             return false;
 
-         bool dependencyFeasible
-            = _dependency.isFeasible(_state,
-                                     process,
-                                     srcMachine,
-                                     dstMachine,
-                                     service,
-                                     machineSrcObj.neighborhood(),
-                                     machineDstObj.neighborhood());
+         bool dependencyFeasible = !Traits::hasDependencies
+            || _dependency.isFeasible(_state,
+                                      process,
+                                      srcMachine,
+                                      dstMachine,
+                                      service,
+                                      machineSrcObj.neighborhood(),
+                                      machineDstObj.neighborhood());
          if (!dependencyFeasible)
             return false;
 
@@ -1258,6 +1463,145 @@ namespace sol
          return true;
       }
 
+      // Evaluates the moves of the process to each of the numMachines
+      // machines, none of which may be its current machine. out[i] is
+      // isFeasible(process, machines[i]) and, if feasible,
+      // evaluateFeasibleMove(process, machines[i]), unless the move is
+      // bounded: its delta is provably not lower than the bound, which
+      // is lowered to the delta of each evaluated move below it. What
+      // only depends on the process and its current machine is
+      // computed once for the whole batch, and the process and
+      // machine move costs are read from the RelocationCosts row of
+      // the process.
+      void evaluateProcessAgainst(
+         int process, integer const * relocationCosts,
+         int const * machines, int numMachines,
+         MoveEvaluation * out,
+         integer bound = std::numeric_limits<integer>::max())
+      {
+         int srcMachine = _state.assignment[process];
+         int initMachine = _state.inst->initAssignment()[process];
+         bool fromInitMachine = srcMachine == initMachine;
+
+         inst::Process const & processObj = _state.inst->process(process);
+         int service = processObj.service();
+
+         inst::Machine const & machineSrcObj = _state.inst->machine(srcMachine);
+         int srcLocation = machineSrcObj.location();
+         int srcNeighborhood = machineSrcObj.neighborhood();
+
+         bool canLeaveLocation
+            = _spread.canLeave(_state, service, srcLocation);
+
+         bool canLeaveNeighborhood = !Traits::hasDependencies
+            || _dependency.canLeave(_state, service, srcNeighborhood);
+
+         integer const * srcMachineUsage = _machineUsage.usage(srcMachine);
+
+         integer const * srcMachineOverSafetyCapacity
+            = _machineUsage.overSafetyCapacity(srcMachine);
+
+         integer srcRelocationCost = relocationCosts[srcMachine];
+
+         // Away from the initial machine, the process and service move
+         // costs don't depend on the destination.
+         integer processMoveAway = _processMove.evaluateMoveProcess(
+            _state, process, fromInitMachine, false);
+         integer processMoveBack = _processMove.evaluateMoveProcess(
+            _state, process, fromInitMachine, true);
+         integer serviceMoveAway = _serviceMove.evaluateMoveProcess(
+            _state, service, fromInitMachine, false);
+         integer serviceMoveBack = _serviceMove.evaluateMoveProcess(
+            _state, service, fromInitMachine, true);
+
+         // Lower bounds of the load and balance deltas, whatever the
+         // destination.
+         integer loadLowerBound = _loadCost.evaluateRemoveProcess(
+            _state, process, srcMachineOverSafetyCapacity);
+
+         integer balanceLowerBound = !Traits::hasBalance ? 0
+            : _balance.lowerBoundMoveProcess(_state, process, srcMachine,
+                                             srcMachineUsage);
+
+         for (int i = 0; i < numMachines; i++)
+         {
+            int dstMachine = machines[i];
+            bool toInitMachine = dstMachine == initMachine;
+            inst::Machine const & machineDstObj
+               = _state.inst->machine(dstMachine);
+
+            // Process and machine move costs.
+            integer deltaObjValueRelocation
+               = relocationCosts[dstMachine] - srcRelocationCost;
+            integer deltaObjValueServiceMove
+               = toInitMachine ? serviceMoveBack : serviceMoveAway;
+
+            integer deltaObjValueMoves
+               = deltaObjValueRelocation + deltaObjValueServiceMove;
+
+            if (deltaObjValueMoves + loadLowerBound + balanceLowerBound
+                >= bound)
+            {
+               out[i].status = MoveEvaluation::bounded;
+               continue;
+            }
+
+            // The constant time checks first, then the capacity and
+            // the load cost in one pass over the resources.
+            integer deltaObjValueLoad;
+
+            bool feasible
+               = _spread.isFeasible(service, srcLocation,
+                                    machineDstObj.location(),
+                                    canLeaveLocation)
+               && (!Traits::hasDependencies
+                   || srcNeighborhood == machineDstObj.neighborhood()
+                   || (canLeaveNeighborhood
+                       && _dependency.canEnter(
+                          _state, service, machineDstObj.neighborhood())))
+               && _conflict.isFeasible(_state, process, srcMachine,
+                                       dstMachine, service)
+               && _loadCost.evaluateMoveProcessIfFits(
+                  _state, process, toInitMachine,
+                  srcMachineOverSafetyCapacity,
+                  _machineUsage.usageWithTransient(dstMachine),
+                  machineDstObj.capacities(),
+                  _machineUsage.underSafetyCapacity(dstMachine),
+                  &deltaObjValueLoad);
+
+            if (!feasible)
+            {
+               out[i].status = MoveEvaluation::infeasible;
+               continue;
+            }
+
+            if (deltaObjValueMoves + deltaObjValueLoad + balanceLowerBound
+                >= bound)
+            {
+               out[i].status = MoveEvaluation::bounded;
+               continue;
+            }
+
+            integer deltaObjValueBalance = !Traits::hasBalance ? 0
+               : _balance.evaluateMoveProcess(
+                  _state, process, srcMachine, dstMachine, srcMachineUsage,
+                  _machineUsage.usage(dstMachine));
+
+            integer deltaObjValueProcessMove
+               = toInitMachine ? processMoveBack : processMoveAway;
+
+            out[i].status = MoveEvaluation::evaluated;
+            out[i].deltaObjValue = ObjValue(
+               deltaObjValueLoad,
+               deltaObjValueBalance,
+               deltaObjValueProcessMove,
+               deltaObjValueServiceMove,
+               deltaObjValueRelocation - deltaObjValueProcessMove);
+
+            bound = std::min(bound, out[i].deltaObjValue.objValue());
+         }
+      }
+
       void moveProcess(int process, int dstMachine,
                        ObjValue const & deltaObjValue)
       {
@@ -1266,12 +1610,71 @@ namespace sol
          if (srcMachine == dstMachine)
             return;
 
+         _journal.push(MoveJournal::Move(process, srcMachine, deltaObjValue));
+
+         applyMove(process, srcMachine, dstMachine, deltaObjValue);
+      }
+
+      typedef std::size_t Checkpoint;
+
+      // Position in the journal of the moves applied since the last
+      // commit().
+      Checkpoint checkpoint() const
+      {
+         return _journal.size();
+      }
+
+      // Undoes, most recent first, the moves applied since the
+      // checkpoint was taken.
+      void rollback(Checkpoint checkpoint)
+      {
+         while (_journal.size() > checkpoint)
+         {
+            MoveJournal::Move const & move = _journal.back();
+            int dstMachine = _state.assignment[move.process];
+
+            applyMove(move.process, dstMachine, move.srcMachine,
+                      move.deltaObjValue.opposite());
+            _journal.pop();
+         }
+      }
+
+      // Forgets the journal: the current solution becomes checkpoint 0.
+      void commit()
+      {
+         _journal.clear();
+      }
+
+      ObjValue const & objValue() const
+      {
+         return _objValue;
+      }
+
+
+   private:
+      BasicSolution(inst::Instance const * instance,
+                    std::vector<int> const & assignment,
+                    ObjValue const & objValue,
+                    AssignmentCounts const & counts)
+         : _state(instance, assignment),
+           _machineUsage(_state, counts),
+           _loadCost(_state),
+           _balance(_state),
+           _serviceMove(_state, counts),
+           _capacity(_state),
+           _conflict(_state),
+           _spread(_state, counts),
+           _dependency(_state, counts),
+           _objValue(objValue)
+      {
+      }
+
+      void applyMove(int process, int srcMachine, int dstMachine,
+                     ObjValue const & deltaObjValue)
+      {
          _machineUsage.moveProcess(_state, process, srcMachine, dstMachine);
          
-         std::vector<integer> const & newSrcMachineUsageTransient
-            = _machineUsage.usageWithTransient(srcMachine);
-         
-         std::vector<integer> const & newDstMachineUsageTransient
+         integer const * newDstMachineUsageTransient
             = _machineUsage.usageWithTransient(dstMachine);
 
          
@@ -1280,7 +1683,10 @@ namespace sol
          // doesn't have any state.
          _conflict.moveProcess(_state, process, srcMachine, dstMachine);
          _spread.moveProcess(_state, process, srcMachine, dstMachine);
-         _dependency.moveProcess(_state, process, srcMachine, dstMachine);
+
+         // Without dependencies, the counts are never read.
+         if (Traits::hasDependencies)
+            _dependency.moveProcess(_state, process, srcMachine, dstMachine);
 
          _state.assignment[process] = dstMachine;
 
@@ -1289,7 +1695,7 @@ namespace sol
 
          inst::Machine const & machineDstObj = _state.inst->machine(dstMachine);
 
-         for (int i = 0; i <  newDstMachineUsageTransient.size(); i++)
+         for (int i = 0; i < Traits::numResources(_state.inst); i++)
          {
             if (newDstMachineUsageTransient[i] > machineDstObj.capacity(i))
             {
@@ -1305,29 +1711,86 @@ namespace sol
          }
       }
 
-      ObjValue const & objValue() const
-      {
-         return _objValue;
-      }
-
-
-   private:
       State _state; 
       
-      MachineUsage _machineUsage; 
+      MachineUsage<Traits> _machineUsage; 
 
-      LoadCost _loadCost;       // No attribute
-      Balance _balance;         // No attribute
+      LoadCost _loadCost;
+      Balance _balance;
       ProcessMove _processMove; // No attribute
       ServiceMove _serviceMove;
       MachineMove _machineMove; // No attribute
 
-      Capacity _capacity;       // No attribute
+      Capacity _capacity;
       Conflict _conflict;
       Spread _spread;
       Dependency _dependency;
 
       ObjValue _objValue;
+
+      MoveJournal _journal;
+   };
+
+   typedef BasicSolution<DynamicTraits> Solution;
+
+   // Compact copy of a solution: its objective value and its
+   // assignment, with the machines stored on 16 bits (Instance rejects
+   // instances with more than inst::Instance::maxNumMachines machines).
+   // None of the incremental structures are kept,
+   // Solution(instance, assignment(), objValue()) rebuilds them.
+   class Snapshot
+   {
+   public:
+      Snapshot()
+      {
+      }
+
+      template <typename SolutionType>
+      explicit Snapshot(SolutionType const & solution)
+      {
+         assign(solution);
+      }
+
+      // Once the snapshot has the size of the assignment, it is
+      // overwritten without allocating.
+      template <typename SolutionType>
+      void assign(SolutionType const & solution)
+      {
+         std::vector<int> const & assignment = solution.assignment();
+
+         _assignment.resize(assignment.size());
+
+         for (int i = 0; i < assignment.size(); i++)
+            _assignment[i] = static_cast<uint16_t>(assignment[i]);
+
+         _objValue = solution.objValue();
+      }
+
+      std::vector<int> assignment() const
+      {
+         return std::vector<int>(_assignment.begin(), _assignment.end());
+      }
+
+      ObjValue const & objValue() const
+      {
+         return _objValue;
+      }
+
+      // Number of processes assigned to different machines (Hamming
+      // distance).
+      int distance(Snapshot const & other) const
+      {
+         int numDifferent = 0;
+
+         for (int i = 0; i < _assignment.size(); i++)
+            numDifferent += _assignment[i] != other._assignment[i];
+
+         return numDifferent;
+      }
+
+   private:
+      std::vector<uint16_t> _assignment;
+      ObjValue _objValue;
    };
 }
 
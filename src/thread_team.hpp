@@ -0,0 +1,133 @@
+#ifndef THREAD_TEAM_HPP
+#define THREAD_TEAM_HPP
+
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+// A fixed team of threads which run the same job together:
+// run(job, context) calls job(context, i) for every member i, member 0
+// being the calling thread, and returns once they have all returned.
+// The other members wait for the next job between two runs, so a run
+// neither creates threads nor allocates.
+class ThreadTeam
+{
+public:
+   typedef void (*Job)(void * context, int member);
+
+   explicit ThreadTeam(int size)
+      : _size(std::max(1, size)),
+        _job(0),
+        _context(0),
+        _generation(0),
+        _numRunning(0),
+        _stop(false)
+   {
+      for (int i = 1; i < _size; i++)
+      {
+         _threads.push_back(boost::shared_ptr<boost::thread>(
+                               new boost::thread(&ThreadTeam::wait, this,
+                                                 i)));
+      }
+   }
+
+   ~ThreadTeam()
+   {
+      boost::this_thread::disable_interruption disableInterruption;
+
+      {
+         boost::mutex::scoped_lock lock(_mutex);
+         _stop = true;
+      }
+
+      _jobReady.notify_all();
+
+      for (int i = 0; i < _threads.size(); i++)
+         _threads[i]->join();
+   }
+
+   int size() const { return _size; }
+
+   // The calling thread can't be interrupted until the other members
+   // are done with the job: they may use its stack.
+   void run(Job job, void * context)
+   {
+      if (_size == 1)
+      {
+         job(context, 0);
+         return;
+      }
+
+      boost::this_thread::disable_interruption disableInterruption;
+
+      {
+         boost::mutex::scoped_lock lock(_mutex);
+         _job = job;
+         _context = context;
+         _numRunning = _size - 1;
+         _generation++;
+      }
+
+      _jobReady.notify_all();
+
+      job(context, 0);
+
+      boost::mutex::scoped_lock lock(_mutex);
+
+      while (_numRunning > 0)
+         _jobDone.wait(lock);
+   }
+
+private:
+   void wait(int member)
+   {
+      unsigned long long generation = 0;
+
+      while (true)
+      {
+         Job job;
+         void * context;
+
+         {
+            boost::mutex::scoped_lock lock(_mutex);
+
+            while (!_stop && _generation == generation)
+               _jobReady.wait(lock);
+
+            if (_stop)
+               return;
+
+            generation = _generation;
+            job = _job;
+            context = _context;
+         }
+
+         job(context, member);
+
+         {
+            boost::mutex::scoped_lock lock(_mutex);
+            _numRunning--;
+         }
+
+         _jobDone.notify_one();
+      }
+   }
+
+   int _size;
+   std::vector<boost::shared_ptr<boost::thread> > _threads;
+
+   boost::mutex _mutex;
+   boost::condition_variable _jobReady;
+   boost::condition_variable _jobDone;
+
+   Job _job;
+   void * _context;
+   unsigned long long _generation;
+   int _numRunning;
+   bool _stop;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef TOKENIZER_HPP
+#define TOKENIZER_HPP
+
+#include "instance.hpp"
+#include "mapped_file.hpp"
+
+#include <string>
+
+// Scans the integers of a whitespace separated text file directly from
+// its memory mapping (no stream, no locale). Any character which is
+// neither a digit nor a minus sign is a separator.
+class Tokenizer
+{
+public:
+   Tokenizer(std::string const & filename)
+      : _file(filename),
+        _pos(_file.data()),
+        _end(_file.data() + _file.size())
+   {
+   }
+
+   // Returns false once the end of the file is reached.
+   bool next(inst::integer & value)
+   {
+      // Work on local copies: the characters read could otherwise
+      // alias the members and force a reload at every step.
+      char const * pos = _pos;
+      char const * end = _end;
+
+      while (pos != end && !startsNumber(*pos))
+         ++pos;
+
+      if (pos == end)
+      {
+         _pos = pos;
+         return false;
+      }
+
+      bool negative = (*pos == '-');
+      pos += negative;
+
+      inst::integer result = 0;
+      unsigned int digit;
+
+      while (pos != end && (digit = digitValue(*pos)) < 10)
+      {
+         result = result * 10 + digit;
+         ++pos;
+      }
+
+      _pos = pos;
+      value = negative ? -result : result;
+      return true;
+   }
+
+   // Same as next(), but returns 0 past the end of the file (as the
+   // former stream-based parser did).
+   inst::integer nextInteger()
+   {
+      inst::integer value = 0;
+      next(value);
+      return value;
+   }
+
+private:
+   static unsigned int digitValue(char c)
+   {
+      return static_cast<unsigned char>(c) - static_cast<unsigned int>('0');
+   }
+
+   static bool startsNumber(char c)
+   {
+      return digitValue(c) < 10 || c == '-';
+   }
+
+   MappedFile _file;
+   char const * _pos;
+   char const * _end;
+};
+
+#endif
@@ -1,86 +1,237 @@
 #ifndef EXECUTE_HPP
 #define EXECUTE_HPP
 
+#include "decomposition.hpp"
 #include "hill_climbing.hpp"
 #include "instance.hpp"
 #include "iterated_ls.hpp"
-#include "parser.hpp"
 #include "pool.hpp"
 #include "random_moves.hpp"
+#include "island.hpp"
 #include "solution.hpp"
 
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_int.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <ctime>
+#include <string>
+#include <vector>
 
 
 class Worker
 {
 public:
-   Worker(boost::program_options::variables_map const & param, 
+   // The instance is parsed once by the caller and shared read-only
+   // by every worker. The island, if any, is the worker's own.
+   Worker(boost::program_options::variables_map const & param,
+          boost::shared_ptr<inst::Instance const> const & instance,
+          Island * island,
           unsigned int seed)
       : _param(param),
+        _instance(instance),
+        _island(island),
         _pool(1),
         _gen(seed)
    {
+      _stats.numEvaluatedMoves = 0;
+      _stats.numBoundedMoves = 0;
+      _stats.numStaleMoves = 0;
+      _stats.numConflicts = 0;
+      _stats.seconds = 0;
    }
    
+   // Runs the search with the Solution instantiated for the instance
+   // (number of resources, transient resources, balance costs and
+   // dependencies), or with the one which reads everything from the
+   // instance if there is none or if --generic is given.
    void operator()()
    {
-      // Memory leak at the end...
-      inst::Instance* instance = createInstance(_param);
+      if (_param.count("generic") > 0)
+      {
+         run<sol::DynamicTraits>();
+         return;
+      }
+
+      switch (_instance->numResources())
+      {
+      case 2: dispatchFeatures<2>(); break;
+      case 3: dispatchFeatures<3>(); break;
+      case 4: dispatchFeatures<4>(); break;
+      case 6: dispatchFeatures<6>(); break;
+      case 12: dispatchFeatures<12>(); break;
+      default: run<sol::DynamicTraits>(); break;
+      }
+   }
 
-      sol::Solution initialSolution(instance);
-      sol::ObjValue initObjValue
-         = initialSolution.computeObjValue();
-      initialSolution.applyDelta(initObjValue);
+   sol::Snapshot const & bestSolution() const
+   {
+      return _pool.getBestSolution();
+   }
 
-      _pool.addSolution(initialSolution);
+   // Set once the worker is interrupted.
+   struct Stats
+   {
+      std::string solution;
+      unsigned long long numEvaluatedMoves;
+      unsigned long long numBoundedMoves;
+      unsigned long long numStaleMoves;
+      unsigned long long numConflicts;
+      double seconds;
+   };
+
+   Stats const & stats() const
+   {
+      return _stats;
+   }
+   
+private:
+   template <int NumResources>
+   void dispatchFeatures()
+   {
+      std::vector<unsigned char> const & isTransient
+         = _instance->isTransient();
+
+      bool transient = std::find(isTransient.begin(), isTransient.end(), 1)
+         != isTransient.end();
+      bool balance = _instance->numBalanceCosts() > 0;
+      bool dependencies = _instance->numDependencies() > 0;
+
+      switch (transient * 4 + balance * 2 + dependencies)
+      {
+      case 0: run<sol::Traits<NumResources, false, false, false> >(); break;
+      case 1: run<sol::Traits<NumResources, false, false, true> >(); break;
+      case 2: run<sol::Traits<NumResources, false, true, false> >(); break;
+      case 3: run<sol::Traits<NumResources, false, true, true> >(); break;
+      case 4: run<sol::Traits<NumResources, true, false, false> >(); break;
+      case 5: run<sol::Traits<NumResources, true, false, true> >(); break;
+      case 6: run<sol::Traits<NumResources, true, true, false> >(); break;
+      default: run<sol::Traits<NumResources, true, true, true> >(); break;
+      }
+   }
+
+   template <typename Traits>
+   void run()
+   {
+      inst::Instance const * instance = _instance.get();
+
+      // Each ILS run leaves the solution at the best solution it found,
+      // which is where the next run starts, unless there is a better
+      // one in the pool of the island.
+      sol::BasicSolution<Traits> solution(instance);
+      sol::ObjValue initObjValue = solution.computeObjValue();
+      solution.applyDelta(initObjValue);
+
+      _pool.addSolution(solution);
 
       RandomMoves randomMoves(
          _dist(_gen),
          *instance,
          instance->numProcesses() * _param["a"].as<double>());
-      
+
+      std::size_t relocationCostsBudget
+         = static_cast<std::size_t>(_param["g"].as<int>()) << 20;
+
+      _stats.solution = Traits::name();
+
+      if (_param["n"].as<int>() > 0)
+      {
+         Decomposition<sol::BasicSolution<Traits> >
+            decomposition(_dist(_gen), *instance, &_pool,
+                          _param["n"].as<int>(),
+                          _param["b"].as<int>(),
+                          _param["e"].as<int>(),
+                          _param["f"].as<int>(),
+                          relocationCostsBudget,
+                          _param["h"].as<int>());
+
+         search(solution, &decomposition, &randomMoves);
+         return;
+      }
+
       HillClimbing hillClimbing(_dist(_gen), *instance, &_pool, 
                                 _param["b"].as<int>(),
                                 _param["e"].as<int>(),
-                                _param["f"].as<int>());
-      
-      IteratedLocalSearch<HillClimbing, RandomMoves>
+                                _param["f"].as<int>(),
+                                relocationCostsBudget,
+                                _param["h"].as<int>(),
+                                _param.count("concurrent-moves") > 0);
+
+      search(solution, &hillClimbing, &randomMoves);
+   }
+
+   // Runs ILS until the worker is interrupted.
+   template <typename Solution, typename LocalSearch>
+   void search(Solution & solution, LocalSearch * localSearch,
+               RandomMoves * randomMoves)
+   {
+      IteratedLocalSearch<LocalSearch, RandomMoves>
          ils(_param["c"].as<int>(),
-             &hillClimbing,
-             &randomMoves,
-             &_pool);
+             localSearch,
+             randomMoves,
+             &_pool,
+             _island,
+             _param["k"].as<int>());
+
+      double start = now();
 
-      do
+      try
+      {
+         do
+         {
+            ils.apply(solution);
+            boost::this_thread::interruption_point();
+
+            if (_island != 0)
+               restart(solution);
+         }
+         while(true);
+      }
+      catch (boost::thread_interrupted const &)
       {
-         sol::Solution solution(bestSolution());
-         ils.apply(solution);
-         boost::this_thread::interruption_point();
+         _stats.numEvaluatedMoves = localSearch->numEvaluatedMoves();
+         _stats.numBoundedMoves = localSearch->numBoundedMoves();
+         _stats.numStaleMoves = localSearch->numStaleMoves();
+         _stats.numConflicts = localSearch->numConflicts();
+         _stats.seconds = now() - start;
+         throw;
       }
-      while(true);
    }
 
-   sol::Solution bestSolution() const
+   // If the pool of the island has a better solution, moves to an
+   // elite solution drawn at random. The solution is rebuilt by the
+   // -h threads of the local search.
+   template <typename Solution>
+   void restart(Solution & solution)
    {
-      return _pool.getBestSolution();
+      inst::integer value = solution.objValue().objValue();
+
+      if (_island->pool()->bestValue() >= value
+          || !_island->pool()->drawSolution(_gen, &_snapshot)
+          || _snapshot.objValue().objValue() == value)
+         return;
+
+      solution = Solution(_instance.get(), _snapshot.assignment(),
+                          _snapshot.objValue(), _param["h"].as<int>());
    }
-   
-private:
 
-   static inst::Instance* createInstance(
-      boost::program_options::variables_map const & param)
+   static double now()
    {
-      std::ifstream instanceFile(param["p"].as<std::string>().c_str());
-      std::ifstream initialSolutionFile(param["i"].as<std::string>().c_str());
-      return Parser::parse(instanceFile, initialSolutionFile);
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
    }
 
    boost::program_options::variables_map const & _param;
+   boost::shared_ptr<inst::Instance const> _instance;
+   Island * _island;
+   sol::Snapshot _snapshot;
    Pool _pool;
    boost::mt19937 _gen;
    boost::uniform_int<unsigned int> _dist;
+   Stats _stats;
 };
 
 #endif